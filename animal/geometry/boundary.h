@@ -0,0 +1,263 @@
+#ifndef ANIMAL_GEOMETRY_BOUNDARY_H
+#define ANIMAL_GEOMETRY_BOUNDARY_H
+
+#include <algorithm>
+#include <vector>
+
+
+
+namespace animal { namespace geometry {
+
+// ----------------------------------------------------------
+//
+//  Boundary class.
+/** Boundary surface of a volume mesh.
+
+    Faces of the tetrahedra and hexahedra given by addTetra()
+    and addHexa() are sorted by vertex set; extract() keeps the
+    faces referenced by one element only, which make up the
+    boundary. The result is expressed in compact indices, i.e.
+    positions in vertices(), so that only boundary vertices
+    need to be copied for rendering.
+    
+    Hexahedra vertices are ordered as two quads (p0, p1, p2, p3)
+    and (p4, p5, p6, p7), with edges p0-p4, p1-p5, p2-p6, p3-p7.
+    Boundary faces keep the orientation they have in their
+    element: outwards for positive tetrahedra.
+    
+    Declaration/Definition file: animal/geometry/boundary.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Boundary
+{
+
+public:
+
+  typedef unsigned int Index;
+  
+  /// Edge between compact indices p0 < p1
+  struct Edge
+  {
+    Index p0, p1;
+    
+    bool operator<(const Edge& e) const
+      { return p0 < e.p0 || ( p0 == e.p0 && p1 < e.p1 ); }
+    bool operator==(const Edge& e) const
+      { return p0 == e.p0 && p1 == e.p1; }
+  };
+  
+  
+  /** @name Constructor */
+  //@{
+  Boundary()
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Add the 4 faces of a tetrahedron
+  void addTetra(Index p0, Index p1, Index p2, Index p3);
+  
+  /// Add the 6 faces of a hexahedron
+  void addHexa(Index p0, Index p1, Index p2, Index p3,
+	       Index p4, Index p5, Index p6, Index p7);
+  
+  /// Keep the boundary faces, build the compact buffers
+  void extract();
+  //@}
+  
+  
+  /** @name Get (after extract) */
+  //@{
+  /// Mesh indices of the boundary vertices, increasing
+  const std::vector<Index>& vertices() const { return vtc; }
+  
+  /// Boundary triangles, 3 compact indices each (quads are split in two)
+  const std::vector<Index>& triangles() const { return tri; }
+  
+  /// Boundary edges (sides of the faces, not quad diagonals), unique
+  const std::vector<Edge>& edges() const { return edg; }
+  
+  /// Number of boundary faces (triangles and quads)
+  int nfaces() const { return faces.size(); }
+  //@}
+
+
+
+private:
+
+  struct Face
+  {
+    int n;      // 3 or 4 vertices
+    Index v[4]; // in element order
+    Index k[4]; // sorted, for comparisons
+    
+    bool operator<(const Face& f) const
+      {
+	if ( n != f.n ) return n < f.n;
+	return std::lexicographical_compare(k, k + n, f.k, f.k + n);
+      }
+    bool operator==(const Face& f) const
+      { return n == f.n && std::equal(k, k + n, f.k); }
+  };
+  
+  void add(Index p0, Index p1, Index p2);
+  void add(Index p0, Index p1, Index p2, Index p3);
+  
+  
+  std::vector<Face> faces;
+  
+  std::vector<Index> vtc;
+  std::vector<Index> tri;
+  std::vector<Edge> edg;
+
+}; // class Boundary
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+inline void
+Boundary::
+addTetra(Index p0, Index p1, Index p2, Index p3)
+{
+  add(p1, p2, p3);
+  add(p0, p3, p2);
+  add(p0, p1, p3);
+  add(p0, p2, p1);
+}
+
+inline void
+Boundary::
+addHexa(Index p0, Index p1, Index p2, Index p3,
+	Index p4, Index p5, Index p6, Index p7)
+{
+  add(p0, p3, p2, p1);
+  add(p4, p5, p6, p7);
+  add(p0, p1, p5, p4);
+  add(p1, p2, p6, p5);
+  add(p2, p3, p7, p6);
+  add(p3, p0, p4, p7);
+}
+
+inline void
+Boundary::
+add(Index p0, Index p1, Index p2)
+{
+  Face f;
+  f.n = 3;
+  f.v[0] = f.k[0] = p0;
+  f.v[1] = f.k[1] = p1;
+  f.v[2] = f.k[2] = p2;
+  f.v[3] = f.k[3] = 0;
+  
+  std::sort(f.k, f.k + 3);
+  faces.push_back(f);
+}
+
+inline void
+Boundary::
+add(Index p0, Index p1, Index p2, Index p3)
+{
+  Face f;
+  f.n = 4;
+  f.v[0] = f.k[0] = p0;
+  f.v[1] = f.k[1] = p1;
+  f.v[2] = f.k[2] = p2;
+  f.v[3] = f.k[3] = p3;
+  
+  std::sort(f.k, f.k + 4);
+  faces.push_back(f);
+}
+
+inline void
+Boundary::
+extract()
+{
+  // Faces shared by two elements are adjacent once sorted
+  std::sort(faces.begin(), faces.end());
+  
+  std::vector<Face>::size_type n = 0;
+  
+  for (std::vector<Face>::size_type i = 0; i < faces.size(); )
+    {
+      std::vector<Face>::size_type j = i + 1;
+      while ( j < faces.size() && faces[j] == faces[i] ) ++j;
+      
+      if ( j == i + 1 ) faces[n++] = faces[i];
+      i = j;
+    }
+  
+  faces.resize(n);
+  
+  // Boundary vertices, and their compact index
+  vtc.clear();
+  for (std::vector<Face>::const_iterator firstf = faces.begin();
+       firstf != faces.end();
+       ++firstf)
+    vtc.insert(vtc.end(), (*firstf).v, (*firstf).v + (*firstf).n);
+  
+  std::sort(vtc.begin(), vtc.end());
+  vtc.erase( std::unique(vtc.begin(), vtc.end()), vtc.end() );
+  
+  std::vector<Index> compact( vtc.empty() ? 0 : vtc.back() + 1 );
+  for (std::vector<Index>::size_type i = 0; i < vtc.size(); ++i)
+    compact[ vtc[i] ] = i;
+  
+  // Triangles and edges
+  tri.clear();
+  edg.clear();
+  
+  for (std::vector<Face>::const_iterator firstf = faces.begin();
+       firstf != faces.end();
+       ++firstf)
+    {
+      const Face& f = *firstf;
+      Index c[4];
+      
+      for (int i = 0; i < f.n; ++i)
+	c[i] = compact[ f.v[i] ];
+      
+      tri.push_back(c[0]); tri.push_back(c[1]); tri.push_back(c[2]);
+      
+      if ( f.n == 4 )
+	{
+	  tri.push_back(c[0]); tri.push_back(c[2]); tri.push_back(c[3]);
+	}
+      
+      for (int i = 0; i < f.n; ++i)
+	{
+	  Edge e;
+	  e.p0 = std::min( c[i], c[(i + 1) % f.n] );
+	  e.p1 = std::max( c[i], c[(i + 1) % f.n] );
+	  edg.push_back(e);
+	}
+    }
+  
+  std::sort(edg.begin(), edg.end());
+  edg.erase( std::unique(edg.begin(), edg.end()), edg.end() );
+}
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_BOUNDARY_H
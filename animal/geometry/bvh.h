@@ -0,0 +1,489 @@
+#ifndef ANIMAL_GEOMETRY_BVH_H
+#define ANIMAL_GEOMETRY_BVH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+
+namespace animal { namespace geometry {
+
+namespace bvh_detail {
+
+// No subtree skipped
+struct No_Skip
+{
+  bool operator()(unsigned int) const { return false; }
+};
+
+} // namespace bvh_detail
+
+// ----------------------------------------------------------
+//
+//  Bvh class.
+/** Bounding volume hierarchy of axis aligned boxes over items
+    (e.g. triangles), refit rather than rebuilt as they move.
+    
+    build() splits the items top down, near the median of their
+    centers along the longest side, down to one item per leaf.
+    Boxes are given by a functor, box(i, lo, hi) setting the
+    float box of item i, read by build() and refit().
+    
+    Nodes are stored depth first: the left child of a node
+    follows it, and every subtree is a range of nodes, so that
+    refitting a subtree is a backward loop over its range. To
+    refit on several threads, the subtrees at some depth (see
+    cut()) are refit independently, then the few nodes above
+    them (see refitAbove()).
+    
+    Overlapping pairs of items are found by descending the
+    tree against itself (see selfPairs() and pairs()); tasks()
+    splits this descent into independent node pairs, to share
+    it between threads as well. Both may skip the pairs within
+    some subtrees, known by the caller not to meet (e.g. flat
+    patches of a surface, see Self_Collision).
+    
+    The tree keeps its structure: after large motions, its
+    boxes overlap more, and a new build() pays off.
+    
+    Declaration/Definition file: animal/geometry/bvh.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Bvh
+{
+
+public:
+
+  typedef unsigned int Index;
+  
+  /// Node pair, a == b for the pairs within one subtree
+  typedef std::pair<Index, Index> Node_Pair;
+  
+  
+  /** @name Constructor */
+  //@{
+  Bvh()
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Tree over items [0, n), of boxes given by box
+  template <class BoxF>
+  void build(Index n, const BoxF& box);
+  
+  /// New boxes of every node
+  template <class BoxF>
+  void refit(const BoxF& box) { if ( !nodes.empty() ) refit(box, 0); }
+  
+  /// New boxes of the subtree of node i
+  template <class BoxF>
+  void refit(const BoxF& box, Index i);
+  
+  /// New boxes of the nodes above depth, their subtrees at depth being refit
+  void refitAbove(int depth) { if ( !nodes.empty() ) fitAbove(0, depth); }
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// Number of nodes (0 for no item)
+  Index size() const { return nodes.size(); }
+  
+  /// Root box
+  const float* lo() const { return nodes[0].lo; }
+  const float* hi() const { return nodes[0].hi; }
+  
+  /** Roots of the subtrees at depth (the root at depth 0), and
+      the leaves above, covering every item once */
+  void cut(int depth, std::vector<Index>& roots) const;
+  
+  /** Node pairs, together covering every pair of items once,
+      from splitting the root (pair (0, 0)) down to depth */
+  void tasks(int depth, std::vector<Node_Pair>& t) const
+    { tasks(depth, t, bvh_detail::No_Skip()); }
+  
+  /// Same, without the pairs within the subtrees i of skip(i) true
+  template <class SkipF>
+  void tasks(int depth, std::vector<Node_Pair>& t, const SkipF& skip) const;
+  //@}
+  
+  
+  /** @name Nodes */
+  //@{
+  /// Leaf node, of one item
+  bool leaf(Index i) const { return nodes[i].end == i + 1; }
+  
+  /// Item of leaf i
+  Index item(Index i) const { return nodes[i].item; }
+  
+  /// Right child of node i, the left one being i + 1
+  Index right(Index i) const { return nodes[i].item; }
+  
+  /// One past the last node of the subtree of node i
+  Index end(Index i) const { return nodes[i].end; }
+  //@}
+  
+  
+  /** @name Overlaps */
+  //@{
+  /// f(i, j) for the items i, j of the subtree of node n whose boxes overlap
+  template <class PairF>
+  void selfPairs(Index n, PairF& f) const { selfPairs(n, f, bvh_detail::No_Skip()); }
+  
+  /// Same, without the pairs within the subtrees i of skip(i) true
+  template <class PairF, class SkipF>
+  void selfPairs(Index n, PairF& f, const SkipF& skip) const;
+  
+  /// f(i, j) for the items i of subtree a and j of subtree b whose boxes overlap
+  template <class PairF>
+  void pairs(Index a, Index b, PairF& f) const;
+  
+  /// selfPairs() or pairs() of node pair p
+  template <class PairF>
+  void pairs(const Node_Pair& p, PairF& f) const { pairs(p, f, bvh_detail::No_Skip()); }
+  
+  template <class PairF, class SkipF>
+  void pairs(const Node_Pair& p, PairF& f, const SkipF& skip) const
+    { if ( p.first == p.second ) selfPairs(p.first, f, skip); else pairs(p.first, p.second, f); }
+  //@}
+
+
+
+private:
+
+  enum { MAX_DEPTH = 80 }; // of the splits (3/4 at most) of 2^32 items
+  
+  struct Node
+  {
+    float lo[3], hi[3];
+    Index end;  // one past the last node of the subtree
+    Index item; // of a leaf, the right child otherwise
+  };
+  
+  bool overlap(Index a, Index b) const
+    {
+      const Node& na = nodes[a];
+      const Node& nb = nodes[b];
+      return na.lo[0] <= nb.hi[0] && nb.lo[0] <= na.hi[0] &&
+	     na.lo[1] <= nb.hi[1] && nb.lo[1] <= na.hi[1] &&
+	     na.lo[2] <= nb.hi[2] && nb.lo[2] <= na.hi[2];
+    }
+  
+  void merge(Index i)
+    {
+      Node& n = nodes[i];
+      const Node& l = nodes[i + 1];
+      const Node& r = nodes[n.item];
+      for (int d = 0; d < 3; ++d)
+	{
+	  n.lo[d] = std::min(l.lo[d], r.lo[d]);
+	  n.hi[d] = std::max(l.hi[d], r.hi[d]);
+	}
+    }
+  
+  // Subtree of items order[first, last), returns its node
+  Index split(Index first, Index last);
+  
+  void fitAbove(Index i, int depth);
+  void cutAt(Index i, int depth, std::vector<Index>& roots) const;
+  template <class SkipF>
+  void selfTasks(Index i, int depth, std::vector<Node_Pair>& t, const SkipF& skip) const;
+  void pairTasks(Index a, Index b, int depth, std::vector<Node_Pair>& t) const;
+  
+  
+  std::vector<Node> nodes;
+  
+  // Build only
+  std::vector<Index> order;
+  std::vector<float> center; // 3 per item
+  std::vector<float> boxes;  // 6 per item
+
+}; // class Bvh
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+namespace bvh_detail {
+
+// Comparison of items along axis d, by their center
+struct Less
+{
+  const float* center;
+  int d;
+  
+  bool operator()(Bvh::Index a, Bvh::Index b) const
+    { return center[3*a + d] < center[3*b + d]; }
+};
+
+} // namespace bvh_detail
+
+template <class BoxF>
+inline void
+Bvh::
+build(Index n, const BoxF& box)
+{
+  nodes.clear();
+  if ( n == 0 ) return;
+  
+  boxes.resize(6*n);
+  center.resize(3*n);
+  order.resize(n);
+  
+  for (Index i = 0; i < n; ++i)
+    {
+      box(i, &boxes[6*i], &boxes[6*i + 3]);
+      for (int d = 0; d < 3; ++d)
+	center[3*i + d] = 0.5f*(boxes[6*i + d] + boxes[6*i + 3 + d]);
+      order[i] = i;
+    }
+  
+  nodes.reserve(2*n - 1);
+  split(0, n);
+  
+  std::vector<Index>().swap(order);
+  std::vector<float>().swap(center);
+  std::vector<float>().swap(boxes);
+}
+
+inline Bvh::Index
+Bvh::
+split(Index first, Index last)
+{
+  const Index i = nodes.size();
+  nodes.push_back( Node() );
+  
+  if ( last - first == 1 )
+    {
+      const float* b = &boxes[6*order[first]];
+      for (int d = 0; d < 3; ++d)
+	{
+	  nodes[i].lo[d] = b[d];
+	  nodes[i].hi[d] = b[3 + d];
+	}
+      nodes[i].item = order[first];
+      nodes[i].end = i + 1;
+      return i;
+    }
+  
+  // Longest side of the centers
+  float lo[3], hi[3];
+  for (int d = 0; d < 3; ++d)
+    lo[d] = hi[d] = center[3*order[first] + d];
+  
+  for (Index k = first + 1; k < last; ++k)
+    for (int d = 0; d < 3; ++d)
+      {
+	lo[d] = std::min(lo[d], center[3*order[k] + d]);
+	hi[d] = std::max(hi[d], center[3*order[k] + d]);
+      }
+  
+  bvh_detail::Less less;
+  less.center = &center[0];
+  less.d = 0;
+  for (int d = 1; d < 3; ++d)
+    if ( hi[d] - lo[d] > hi[less.d] - lo[less.d] ) less.d = d;
+  
+  // At the widest gap between the centers of the middle half, so as
+  // not to cut through rows of items (e.g. the triangles of a grid)
+  std::sort(order.begin() + first, order.begin() + last, less);
+  
+  const Index n = last - first;
+  Index middle = first + n/2;
+  float gap = -1.0f;
+  
+  for (Index k = first + n/4 + 1; k <= first + 3*n/4; ++k)
+    {
+      float g = center[3*order[k] + less.d] - center[3*order[k - 1] + less.d];
+      if ( g > gap )
+	{
+	  gap = g;
+	  middle = k;
+	}
+    }
+  
+  split(first, middle);
+  Index right = split(middle, last);
+  
+  nodes[i].item = right;
+  nodes[i].end = nodes.size();
+  merge(i);
+  
+  return i;
+}
+
+template <class BoxF>
+inline void
+Bvh::
+refit(const BoxF& box, Index i)
+{
+  for (Index k = nodes[i].end; k-- > i; )
+    if ( leaf(k) )
+      box(nodes[k].item, nodes[k].lo, nodes[k].hi);
+    else
+      merge(k);
+}
+
+inline void
+Bvh::
+fitAbove(Index i, int depth)
+{
+  if ( depth == 0 || leaf(i) ) return;
+  
+  fitAbove(i + 1, depth - 1);
+  fitAbove(nodes[i].item, depth - 1);
+  merge(i);
+}
+
+inline void
+Bvh::
+cut(int depth, std::vector<Index>& roots) const
+{
+  roots.clear();
+  if ( !nodes.empty() ) cutAt(0, depth, roots);
+}
+
+inline void
+Bvh::
+cutAt(Index i, int depth, std::vector<Index>& roots) const
+{
+  if ( depth == 0 || leaf(i) )
+    {
+      roots.push_back(i);
+      return;
+    }
+  
+  cutAt(i + 1, depth - 1, roots);
+  cutAt(nodes[i].item, depth - 1, roots);
+}
+
+template <class SkipF>
+inline void
+Bvh::
+tasks(int depth, std::vector<Node_Pair>& t, const SkipF& skip) const
+{
+  t.clear();
+  if ( !nodes.empty() ) selfTasks(0, depth, t, skip);
+}
+
+template <class SkipF>
+inline void
+Bvh::
+selfTasks(Index i, int depth, std::vector<Node_Pair>& t, const SkipF& skip) const
+{
+  if ( leaf(i) || skip(i) ) return; // no pair
+  
+  if ( depth == 0 )
+    {
+      t.push_back( Node_Pair(i, i) );
+      return;
+    }
+  
+  selfTasks(i + 1, depth - 1, t, skip);
+  selfTasks(nodes[i].item, depth - 1, t, skip);
+  pairTasks(i + 1, nodes[i].item, depth - 1, t);
+}
+
+inline void
+Bvh::
+pairTasks(Index a, Index b, int depth, std::vector<Node_Pair>& t) const
+{
+  if ( depth <= 0 || ( leaf(a) && leaf(b) ) )
+    {
+      t.push_back( Node_Pair(a, b) );
+      return;
+    }
+  
+  if ( leaf(a) )
+    {
+      pairTasks(a, b + 1, depth - 1, t);
+      pairTasks(a, nodes[b].item, depth - 1, t);
+    }
+  else if ( leaf(b) )
+    {
+      pairTasks(a + 1, b, depth - 1, t);
+      pairTasks(nodes[a].item, b, depth - 1, t);
+    }
+  else
+    {
+      pairTasks(a + 1, b + 1, depth - 1, t);
+      pairTasks(a + 1, nodes[b].item, depth - 1, t);
+      pairTasks(nodes[a].item, b + 1, depth - 1, t);
+      pairTasks(nodes[a].item, nodes[b].item, depth - 1, t);
+    }
+}
+
+template <class PairF, class SkipF>
+inline void
+Bvh::
+selfPairs(Index n, PairF& f, const SkipF& skip) const
+{
+  if ( leaf(n) || skip(n) ) return;
+  
+  selfPairs(n + 1, f, skip);
+  selfPairs(nodes[n].item, f, skip);
+  pairs(n + 1, nodes[n].item, f);
+}
+
+template <class PairF>
+inline void
+Bvh::
+pairs(Index a, Index b, PairF& f) const
+{
+  if ( !overlap(a, b) ) return;
+  
+  // Overlapping pairs still to descend, at most one per level of
+  // both subtrees
+  Node_Pair stack[2*MAX_DEPTH + 2];
+  int n = 0;
+  stack[n++] = Node_Pair(a, b);
+  
+  while ( n > 0 )
+    {
+      a = stack[--n].first;
+      b = stack[n].second;
+      
+      const bool la = leaf(a), lb = leaf(b);
+      
+      if ( la && lb )
+	f(nodes[a].item, nodes[b].item);
+      else if ( lb || ( !la && nodes[a].end - a >= nodes[b].end - b ) )
+	{
+	  // Larger subtree first
+	  if ( overlap(nodes[a].item, b) ) stack[n++] = Node_Pair(nodes[a].item, b);
+	  if ( overlap(a + 1, b) ) stack[n++] = Node_Pair(a + 1, b);
+	}
+      else
+	{
+	  if ( overlap(a, nodes[b].item) ) stack[n++] = Node_Pair(a, nodes[b].item);
+	  if ( overlap(a, b + 1) ) stack[n++] = Node_Pair(a, b + 1);
+	}
+    }
+}
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_BVH_H
@@ -0,0 +1,264 @@
+#ifndef ANIMAL_GEOMETRY_PARTITION_H
+#define ANIMAL_GEOMETRY_PARTITION_H
+
+#include <cstddef>
+#include <vector>
+
+
+
+namespace animal { namespace geometry {
+
+// ----------------------------------------------------------
+//
+//  Partition class.
+/** Partition of the elements of a mesh into parts of nearly
+    equal sizes, with few vertices shared between parts.
+    
+    Elements are the nodes of a graph, two elements being
+    adjacent when they share a vertex. split() orders the
+    elements breadth first from a pseudo-peripheral element
+    (the last one reached from another peripheral element),
+    then cuts the order into consecutive parts: parts are
+    level sets, slabs across the longest direction of the
+    mesh, whose interfaces are small for the elongated meshes
+    (beams). Disconnected components are ordered one after
+    the other.
+    
+    Each vertex belongs to the lowest part among its elements
+    (see owners()); interface vertices are those of elements
+    of several parts.
+    
+    The breadth first order and its levels are kept (see
+    order() and levels()): elements of levels farther apart
+    than one share no vertex, so that groups of whole
+    consecutive levels, taken every other one, can be worked
+    on at the same time.
+    
+    Declaration/Definition file: animal/geometry/partition.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Partition
+{
+
+public:
+
+  typedef unsigned int Index;
+  
+  
+  /** @name Constructor */
+  //@{
+  Partition() : np(0), nshared(0)
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Add an element of n vertices
+  void addElement(int n, const Index v[]);
+  
+  /// Split the elements into nparts parts (nparts >= 1)
+  void split(int nparts);
+  //@}
+  
+  
+  /** @name Get (after split) */
+  //@{
+  /// Number of parts
+  int nparts() const { return np; }
+  
+  /// Part of each element, in the order of addElement()
+  const std::vector<int>& parts() const { return prt; }
+  
+  /// Part owning each vertex, -1 for vertices of no element
+  const std::vector<int>& owners() const { return own; }
+  
+  /// True if vertex v belongs to elements of several parts
+  bool isInterface(Index v) const { return shared[v]; }
+  
+  /// Number of interface vertices
+  Index ninterface() const { return nshared; }
+  
+  /// Elements in breadth first order
+  const std::vector<Index>& order() const { return ord; }
+  
+  /** Start of each breadth first level in order(), and the
+      number of elements */
+  const std::vector<Index>& levels() const { return lvl; }
+  //@}
+
+
+
+private:
+
+  // Breadth first order from element e0 over the unvisited
+  // elements, appended to order, with the start of each level
+  // appended to levels if not 0; returns the last element reached
+  Index visit(Index e0, std::vector<bool>& visited, std::vector<Index>& order,
+	      std::vector<Index>* levels = 0) const;
+  
+  
+  // Elements, as vertex lists
+  std::vector<Index> first; // of each element in vtc, and the end
+  std::vector<Index> vtc;
+  
+  // Elements of each vertex
+  std::vector<Index> vfirst;
+  std::vector<Index> velt;
+  
+  std::vector<Index> ord;
+  std::vector<Index> lvl;
+  
+  int np;
+  std::vector<int> prt;
+  std::vector<int> own;
+  std::vector<bool> shared;
+  Index nshared;
+
+}; // class Partition
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+inline void
+Partition::
+addElement(int n, const Index v[])
+{
+  if ( first.empty() ) first.push_back(0);
+  
+  vtc.insert(vtc.end(), v, v + n);
+  first.push_back( vtc.size() );
+}
+
+inline Partition::Index
+Partition::
+visit(Index e0, std::vector<bool>& visited, std::vector<Index>& order,
+      std::vector<Index>* levels) const
+{
+  std::vector<Index>::size_type head = order.size();
+  std::vector<Index>::size_type level_end = head; // of the current level
+  
+  order.push_back(e0);
+  visited[e0] = true;
+  
+  while ( head < order.size() )
+    {
+      if ( head == level_end )
+	{
+	  if ( levels ) levels->push_back(head);
+	  level_end = order.size();
+	}
+      
+      Index e = order[head++];
+      
+      for (Index i = first[e]; i < first[e + 1]; ++i)
+	{
+	  Index v = vtc[i];
+	  
+	  for (Index j = vfirst[v]; j < vfirst[v + 1]; ++j)
+	    if ( !visited[ velt[j] ] )
+	      {
+		visited[ velt[j] ] = true;
+		order.push_back( velt[j] );
+	      }
+	}
+    }
+  
+  return order.back();
+}
+
+inline void
+Partition::
+split(int nparts)
+{
+  const Index ne = first.empty() ? 0 : first.size() - 1;
+  
+  Index nv = 0;
+  for (std::vector<Index>::size_type i = 0; i < vtc.size(); ++i)
+    if ( vtc[i] + 1 > nv ) nv = vtc[i] + 1;
+  
+  // Elements of each vertex (counting sort)
+  vfirst.assign(nv + 1, 0);
+  for (std::vector<Index>::size_type i = 0; i < vtc.size(); ++i)
+    ++vfirst[ vtc[i] + 1 ];
+  for (Index v = 0; v < nv; ++v)
+    vfirst[v + 1] += vfirst[v];
+  
+  velt.resize( vtc.size() );
+  std::vector<Index> next(vfirst.begin(), vfirst.end() - 1);
+  for (Index e = 0; e < ne; ++e)
+    for (Index i = first[e]; i < first[e + 1]; ++i)
+      velt[ next[ vtc[i] ]++ ] = e;
+  
+  // Breadth first order, each component from a pseudo-peripheral element
+  std::vector<Index>& order = ord;
+  order.clear();
+  order.reserve(ne);
+  lvl.clear();
+  
+  std::vector<bool> visited(ne, false);
+  std::vector<bool> trial(ne, false);
+  std::vector<Index> tmp;
+  
+  for (Index e = 0; e < ne; ++e)
+    if ( !visited[e] )
+      {
+	tmp.clear();
+	Index seed = visit(e, trial, tmp); // farthest from e
+	
+	visit(seed, visited, order, &lvl);
+      }
+  lvl.push_back(ne);
+  
+  // Consecutive parts
+  np = nparts;
+  prt.assign(ne, 0);
+  for (Index k = 0; k < ne; ++k)
+    prt[ order[k] ] = static_cast<int>( std::size_t(k)*np/ne );
+  
+  // Owners and interface vertices
+  own.assign(nv, -1);
+  shared.assign(nv, false);
+  nshared = 0;
+  
+  for (Index v = 0; v < nv; ++v)
+    for (Index j = vfirst[v]; j < vfirst[v + 1]; ++j)
+      {
+	int p = prt[ velt[j] ];
+	
+	if ( own[v] < 0 || p < own[v] )
+	  {
+	    if ( own[v] >= 0 ) shared[v] = true;
+	    own[v] = p;
+	  }
+	else if ( p != own[v] )
+	  shared[v] = true;
+      }
+  
+  for (Index v = 0; v < nv; ++v)
+    if ( shared[v] ) ++nshared;
+}
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_PARTITION_H
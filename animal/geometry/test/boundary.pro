@@ -0,0 +1,9 @@
+#
+# boundary.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= boundary_test.C
+TARGET		= boundary_test
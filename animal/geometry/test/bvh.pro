@@ -0,0 +1,9 @@
+#
+# bvh.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= bvh_test.C
+TARGET		= bvh_test
@@ -0,0 +1,9 @@
+#
+# partition.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= partition_test.C
+TARGET		= partition_test
@@ -0,0 +1,9 @@
+#
+# quaternion_batch.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= quaternion_batch_test.C
+TARGET		= quaternion_batch_test
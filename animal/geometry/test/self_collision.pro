@@ -0,0 +1,10 @@
+#
+# self_collision.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= self_collision_test.C ../../../intersect_triangle.c
+TARGET		= self_collision_test
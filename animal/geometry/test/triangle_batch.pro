@@ -0,0 +1,9 @@
+#
+# triangle_batch.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= triangle_batch_test.C ../../../intersect_triangle.c
+TARGET		= triangle_batch_test
@@ -0,0 +1,9 @@
+#
+# uniform_grid.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= uniform_grid_test.C
+TARGET		= uniform_grid_test
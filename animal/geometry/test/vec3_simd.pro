@@ -0,0 +1,12 @@
+#
+# vec3_simd.pro
+# qmake project file
+# (vec3_test with the 4-lane specializations)
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+DEFINES		= ANIMAL_SIMD
+QMAKE_CXXFLAGS	+= -mavx
+SOURCES		= vec3_test.C
+TARGET		= vec3_simd_test
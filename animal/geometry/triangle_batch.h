@@ -0,0 +1,186 @@
+#ifndef ANIMAL_GEOMETRY_TRIANGLE_BATCH_H
+#define ANIMAL_GEOMETRY_TRIANGLE_BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+
+
+namespace animal { namespace geometry {
+
+// ----------------------------------------------------------
+//
+//  Triangle_Batch class.
+/** Segment-triangle intersection tests, many at once.
+
+    The test is the ray-triangle test of Moller and Trumbore
+    (intersect_triangle.c, without culling), its ray being a
+    segment from o to o + d: it crosses the triangle for a ray
+    parameter t in [0, 1].
+    
+    Segments and triangles are stored as structures of arrays,
+    one array per coordinate, and intersect() computes every
+    test without branches, all the bounds being tested, so
+    that the loop is vectorized by the compiler (at -O3, or -O2
+    -ftree-vectorize). Results are those of intersect_triangle()
+    for the same values.
+    
+    Declaration/Definition file: animal/geometry/triangle_batch.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+template <class RealT>
+class Triangle_Batch
+{
+
+public:
+
+  typedef RealT Real;
+  
+  
+  /** @name Constructor */
+  //@{
+  Triangle_Batch() : n(0)
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// No test
+  void clear() { n = 0; }
+  
+  /** Add the test of segment [o, o + d] against triangle (a,
+      b, c); returns its index */
+  template <class V>
+  std::size_t add(const V& o, const V& d, const V& a, const V& b, const V& c);
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// Number of tests
+  std::size_t size() const { return n; }
+  
+  /// Run the tests
+  void intersect();
+  
+  /// Result of test i (after intersect())
+  bool hit(std::size_t i) const { return hits[i] != 0; }
+  //@}
+
+
+
+private:
+
+  enum { COORDINATES = 15 }; // o, d, vertex 0, edges 1 and 2
+  
+  void grow();
+  
+  
+  std::size_t n;
+  std::vector<Real> data[COORDINATES];
+  std::vector<int> hits;
+
+}; // class Triangle_Batch
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+template <class RealT>
+inline void
+Triangle_Batch<RealT>::
+grow()
+{
+  std::size_t capacity = data[0].empty() ? 64 : 2*data[0].size();
+  
+  for (int k = 0; k < COORDINATES; ++k)
+    data[k].resize(capacity);
+  hits.resize(capacity);
+}
+
+template <class RealT>
+template <class V>
+inline std::size_t
+Triangle_Batch<RealT>::
+add(const V& o, const V& d, const V& a, const V& b, const V& c)
+{
+  if ( n == data[0].size() ) grow();
+  
+  for (int k = 0; k < 3; ++k)
+    {
+      data[k][n]      = o[k];
+      data[3 + k][n]  = d[k];
+      data[6 + k][n]  = a[k];
+      data[9 + k][n]  = b[k] - a[k];
+      data[12 + k][n] = c[k] - a[k];
+    }
+  
+  return n++;
+}
+
+template <class RealT>
+inline void
+Triangle_Batch<RealT>::
+intersect()
+{
+  const Real epsilon = 0.000001; // EPSILON of intersect_triangle.c
+  
+  const Real* ox  = &data[0][0];  const Real* oy  = &data[1][0];  const Real* oz  = &data[2][0];
+  const Real* dx  = &data[3][0];  const Real* dy  = &data[4][0];  const Real* dz  = &data[5][0];
+  const Real* ax  = &data[6][0];  const Real* ay  = &data[7][0];  const Real* az  = &data[8][0];
+  const Real* e1x = &data[9][0];  const Real* e1y = &data[10][0]; const Real* e1z = &data[11][0];
+  const Real* e2x = &data[12][0]; const Real* e2y = &data[13][0]; const Real* e2z = &data[14][0];
+  int* h = n ? &hits[0] : 0;
+  
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      // pvec = dir x edge2, det = edge1 . pvec
+      Real px = dy[i]*e2z[i] - dz[i]*e2y[i];
+      Real py = dz[i]*e2x[i] - dx[i]*e2z[i];
+      Real pz = dx[i]*e2y[i] - dy[i]*e2x[i];
+      Real det = e1x[i]*px + e1y[i]*py + e1z[i]*pz;
+      Real inv_det = 1.0/det;
+      
+      // tvec = orig - vert0, u = tvec . pvec
+      Real tx = ox[i] - ax[i];
+      Real ty = oy[i] - ay[i];
+      Real tz = oz[i] - az[i];
+      Real u = (tx*px + ty*py + tz*pz) * inv_det;
+      
+      // qvec = tvec x edge1, v = dir . qvec, t = edge2 . qvec
+      Real qx = ty*e1z[i] - tz*e1y[i];
+      Real qy = tz*e1x[i] - tx*e1z[i];
+      Real qz = tx*e1y[i] - ty*e1x[i];
+      Real v = (dx[i]*qx + dy[i]*qy + dz[i]*qz) * inv_det;
+      Real t = (e2x[i]*qx + e2y[i]*qy + e2z[i]*qz) * inv_det;
+      
+      h[i] = ( det <= -epsilon || det >= epsilon ) &
+	     ( u >= 0.0 ) & ( u <= 1.0 ) &
+	     ( v >= 0.0 ) & ( u + v <= 1.0 ) &
+	     ( t >= 0.0 ) & ( t <= 1.0 );
+    }
+}
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_TRIANGLE_BATCH_H
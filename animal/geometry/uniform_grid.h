@@ -0,0 +1,247 @@
+#ifndef ANIMAL_GEOMETRY_UNIFORM_GRID_H
+#define ANIMAL_GEOMETRY_UNIFORM_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+
+namespace animal { namespace geometry {
+
+// ----------------------------------------------------------
+//
+//  Uniform_Grid class.
+/** Uniform grid of cubic cells over boxes (e.g. the bounding
+    boxes of obstacles), to find the boxes near a point.
+    
+    add() puts an item in every cell its box overlaps; build()
+    sorts the items by cell and hashes the non-empty cells
+    (open addressing, linear probing), so that the grid has no
+    bounds and its memory follows the number of items, not the
+    extent of the scene. The items of the cell of a point are
+    then a range of items(), found in constant time.
+    
+    Queries are read only, hence safe from several threads.
+    Items whose box spans many cells are repeated in each one:
+    the cell size should be about the size of the boxes.
+    
+    Declaration/Definition file: animal/geometry/uniform_grid.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Uniform_Grid
+{
+
+public:
+
+  typedef unsigned int Index;
+  
+  /// Integer coordinates of a cell
+  struct Cell
+  {
+    int i, j, k;
+    
+    bool operator<(const Cell& c) const
+      { return i < c.i || ( i == c.i && ( j < c.j || ( j == c.j && k < c.k ) ) ); }
+    bool operator==(const Cell& c) const
+      { return i == c.i && j == c.j && k == c.k; }
+    bool operator!=(const Cell& c) const
+      { return !(*this == c); }
+  };
+  
+  
+  /** @name Constructor */
+  //@{
+  /// Grid of cells of size h
+  Uniform_Grid(double h = 1.0) : size(h), nfull(0)
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Remove every item, next cells of size h
+  void clear(double h);
+  
+  /// Add item id, of box [lo, hi] (any type with operator[])
+  template <class V>
+  void add(Index id, const V& lo, const V& hi);
+  
+  /// Sort the items by cell, before any query
+  void build();
+  //@}
+  
+  
+  /** @name Get (after build) */
+  //@{
+  /// Size of the cells
+  double cellSize() const { return size; }
+  
+  /// Cell of point p
+  template <class V>
+  Cell cell(const V& p) const;
+  
+  /** Items of cell c: [first, last) in items(), first == last
+      if there is none */
+  void find(const Cell& c, Index& first, Index& last) const;
+  
+  /// Items, cell by cell
+  const std::vector<Index>& items() const { return itm; }
+  
+  /// Number of non-empty cells
+  Index ncells() const { return nfull; }
+  //@}
+
+
+
+private:
+
+  struct Slot
+  {
+    Cell c;
+    Index first, last; // first == last for an empty slot
+  };
+  
+  static std::size_t hash(const Cell& c)
+    {
+      return std::size_t(c.i)*73856093u ^ std::size_t(c.j)*19349663u ^ std::size_t(c.k)*83492791u;
+    }
+  
+  int coordinate(double x) const
+    { return static_cast<int>( std::floor(x/size) ); }
+  
+  
+  double size;
+  
+  std::vector< std::pair<Cell, Index> > added; // until build()
+  
+  std::vector<Slot> table; // power of 2 slots
+  std::vector<Index> itm;
+  Index nfull;
+
+}; // class Uniform_Grid
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+inline void
+Uniform_Grid::
+clear(double h)
+{
+  size = h;
+  added.clear();
+  table.clear();
+  itm.clear();
+  nfull = 0;
+}
+
+template <class V>
+inline void
+Uniform_Grid::
+add(Index id, const V& lo, const V& hi)
+{
+  Cell c0 = cell(lo), c1 = cell(hi);
+  Cell c;
+  
+  for (c.i = c0.i; c.i <= c1.i; ++c.i)
+    for (c.j = c0.j; c.j <= c1.j; ++c.j)
+      for (c.k = c0.k; c.k <= c1.k; ++c.k)
+	added.push_back( std::make_pair(c, id) );
+}
+
+template <class V>
+inline Uniform_Grid::Cell
+Uniform_Grid::
+cell(const V& p) const
+{
+  Cell c;
+  c.i = coordinate(p[0]);
+  c.j = coordinate(p[1]);
+  c.k = coordinate(p[2]);
+  return c;
+}
+
+inline void
+Uniform_Grid::
+build()
+{
+  std::sort(added.begin(), added.end());
+  
+  // Items, cell by cell
+  itm.resize( added.size() );
+  for (std::size_t n = 0; n < added.size(); ++n)
+    itm[n] = added[n].second;
+  
+  nfull = 0;
+  for (std::size_t n = 0; n < added.size(); ++n)
+    if ( n == 0 || added[n].first != added[n - 1].first ) ++nfull;
+  
+  // At most half full
+  std::size_t nslots = 1;
+  while ( nslots < 2*nfull ) nslots *= 2;
+  
+  Slot empty;
+  empty.c.i = empty.c.j = empty.c.k = 0;
+  empty.first = empty.last = 0;
+  table.assign(nslots, empty);
+  
+  for (std::size_t n = 0; n < added.size(); )
+    {
+      std::size_t m = n + 1;
+      while ( m < added.size() && added[m].first == added[n].first ) ++m;
+      
+      std::size_t s = hash(added[n].first) & (nslots - 1);
+      while ( table[s].first != table[s].last ) s = (s + 1) & (nslots - 1);
+      
+      table[s].c = added[n].first;
+      table[s].first = n;
+      table[s].last = m;
+      
+      n = m;
+    }
+  
+  added.clear();
+}
+
+inline void
+Uniform_Grid::
+find(const Cell& c, Index& first, Index& last) const
+{
+  first = last = 0;
+  if ( table.empty() ) return;
+  
+  const std::size_t mask = table.size() - 1;
+  
+  for (std::size_t s = hash(c) & mask; table[s].first != table[s].last; s = (s + 1) & mask)
+    if ( table[s].c == c )
+      {
+	first = table[s].first;
+	last = table[s].last;
+	return;
+      }
+}
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_UNIFORM_GRID_H
@@ -135,6 +135,15 @@ public:
   //@}
   
   
+  /** @name Linear combination */
+  //@{
+  /// Sum of k[j]*x[i[j]] for j < n
+  template <class R, class NT, class IndexT>
+  friend Vec2<R,NT>
+  lincomb(int , const R [], const Vec2<R,NT> [], const IndexT [] );
+  //@}
+  
+  
   /** @name Norms */
   //@{
   /// Norm (aka l-2 norm, euclidean norm)
@@ -206,6 +215,13 @@ RealT sqdist(const Vec2<RealT,NumTraitsT>& p1, const Vec2<RealT,NumTraitsT>& p2)
 template <class RealT, class NumTraitsT>
 RealT cosAng(const Vec2<RealT,NumTraitsT>& v1, const Vec2<RealT,NumTraitsT>& v2);
 
+/** Linear combination k[0]*x[i[0]] + ... + k[n-1]*x[i[n-1]] (n > 0),
+    accumulated coordinate by coordinate, in this order: same result
+    as the chain of operators, without Vec2 temporaries, which
+    matters in debug builds (optimized builds remove them anyway). */
+template <class RealT, class NumTraitsT, class IndexT>
+Vec2<RealT,NumTraitsT> lincomb(int n, const RealT k[], const Vec2<RealT,NumTraitsT> x[], const IndexT i[]);
+
 //@} // Vec2 class-related methods
 
 
@@ -533,6 +549,29 @@ cosAng(const Vec2<RealT,NumTraitsT>& v1, const Vec2<RealT,NumTraitsT>& v2)
   return dot(v1,v2)/NumTraitsT::sqroot( v1.sqnorm()*v2.sqnorm() );
 }
 
+
+
+
+
+template <class RealT, class NumTraitsT, class IndexT>
+inline Vec2<RealT,NumTraitsT>
+lincomb(int n, const RealT k[], const Vec2<RealT,NumTraitsT> x[], const IndexT i[])
+{
+  const RealT* a = x[ i[0] ].a;
+  
+  RealT x0 = k[0]*a[0];
+  RealT y0 = k[0]*a[1];
+  
+  for (int j = 1; j < n; ++j)
+    {
+      a = x[ i[j] ].a;
+      x0 += k[j]*a[0];
+      y0 += k[j]*a[1];
+    }
+  
+  return Vec2<RealT,NumTraitsT>(x0, y0);
+}
+
 } } // namespace animal { namespace geometry {
 
 
@@ -13,6 +13,10 @@ namespace animal { namespace geometry {
 //  Vec3 class.
 /** Vector (or point) in 3D space.
     
+    When ANIMAL_SIMD is defined, Vec3<float> (and Vec3<double>
+    when compiling for AVX) is specialized to use a 4-lane
+    register, with the same interface (see vec3_simd.h).
+    
     Declaration/Definition file: animal/geometry/vec3.h
     (creation date: December 3, 1999).
     
@@ -42,6 +46,10 @@ public:
   
   /// Constructor: create a Vec3 with 3 Real values
   Vec3(const Real , const Real , const Real );
+  
+  /// Conversion from a Vec3 of another precision
+  template <class R, class NT>
+  explicit Vec3(const Vec3<R,NT>& );
   //@}
   
   
@@ -141,6 +149,15 @@ public:
   //@}
   
   
+  /** @name Linear combination */
+  //@{
+  /// Sum of k[j]*x[i[j]] for j < n
+  template <class R, class NT, class IndexT>
+  friend Vec3<R,NT>
+  lincomb(int , const R [], const Vec3<R,NT> [], const IndexT [] );
+  //@}
+  
+  
   /** @name Norms */
   //@{
   /// Norm (aka l-2 norm, euclidean norm)
@@ -212,6 +229,13 @@ RealT sqdist(const Vec3<RealT,NumTraitsT>& p1, const Vec3<RealT,NumTraitsT>& p2)
 template <class RealT, class NumTraitsT>
 RealT cosAng(const Vec3<RealT,NumTraitsT>& v1, const Vec3<RealT,NumTraitsT>& v2);
 
+/** Linear combination k[0]*x[i[0]] + ... + k[n-1]*x[i[n-1]] (n > 0),
+    accumulated coordinate by coordinate, in this order: same result
+    as the chain of operators, without Vec3 temporaries, which
+    matters in debug builds (optimized builds remove them anyway). */
+template <class RealT, class NumTraitsT, class IndexT>
+Vec3<RealT,NumTraitsT> lincomb(int n, const RealT k[], const Vec3<RealT,NumTraitsT> x[], const IndexT i[]);
+
 //@} // Vec3 class-related methods
 
 
@@ -243,6 +267,15 @@ Vec3(const Real x0, const Real y0, const Real z0)
   a[0] = x0; a[1] = y0; a[2] = z0;
 }
 
+template <class RealT, class NumTraitsT>
+template <class R, class NT>
+inline
+Vec3<RealT,NumTraitsT>::
+Vec3(const Vec3<R,NT>& v)
+{
+  a[0] = v[0]; a[1] = v[1]; a[2] = v[2];
+}
+
 
 
 
@@ -565,8 +598,39 @@ cosAng(const Vec3<RealT,NumTraitsT>& v1, const Vec3<RealT,NumTraitsT>& v2)
   return dot(v1,v2)/NumTraitsT::sqroot( v1.sqnorm()*v2.sqnorm() );
 }
 
+
+
+
+
+template <class RealT, class NumTraitsT, class IndexT>
+inline Vec3<RealT,NumTraitsT>
+lincomb(int n, const RealT k[], const Vec3<RealT,NumTraitsT> x[], const IndexT i[])
+{
+  const RealT* a = x[ i[0] ].a;
+  
+  RealT x0 = k[0]*a[0];
+  RealT y0 = k[0]*a[1];
+  RealT z0 = k[0]*a[2];
+  
+  for (int j = 1; j < n; ++j)
+    {
+      a = x[ i[j] ].a;
+      x0 += k[j]*a[0];
+      y0 += k[j]*a[1];
+      z0 += k[j]*a[2];
+    }
+  
+  return Vec3<RealT,NumTraitsT>(x0, y0, z0);
+}
+
 } } // namespace animal { namespace geometry {
 
 
 
+#if ANIMAL_SIMD
+#include <animal/geometry/vec3_simd.h>
+#endif
+
+
+
 #endif // ANIMAL_GEOMETRY_VEC3_H
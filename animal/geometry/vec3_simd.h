@@ -0,0 +1,374 @@
+#ifndef ANIMAL_GEOMETRY_VEC3_SIMD_H
+#define ANIMAL_GEOMETRY_VEC3_SIMD_H
+
+// Included by vec3.h when ANIMAL_SIMD is defined
+
+
+
+namespace animal { namespace geometry {
+
+// -----------------------------------------------------
+//
+//  Vec3_Lanes class.
+/** 4-lane register types for Vec3<float> and Vec3<double>.
+
+    GCC vector extensions: 4 floats fit an SSE register, 4
+    doubles an AVX one. Without AVX (see -mavx), 4 doubles are
+    split in SSE2 halves, which is slower than the generic Vec3;
+    Vec3<double> is only specialized when __AVX__ is defined.
+    It is kept 16-byte aligned, as given by operator new and
+    std::allocator, and is read with unaligned loads.
+    
+    Declaration/Definition file: animal/geometry/vec3_simd.h
+    (creation date: October 19, 2026). */
+//
+// -----------------------------------------------------
+
+template <class RealT> struct Vec3_Lanes
+{};
+
+template <> struct Vec3_Lanes<float>
+{
+  typedef float Pack __attribute__ ((vector_size (16)));
+  typedef int   Mask __attribute__ ((vector_size (16)));
+};
+
+#ifdef __AVX__
+template <> struct Vec3_Lanes<double>
+{
+  typedef double    Pack __attribute__ ((vector_size (32), aligned (16)));
+  typedef long long Mask __attribute__ ((vector_size (32)));
+};
+#endif
+
+
+
+// -----------------------------------------------------
+//
+//  Vec3_Packed class.
+/** Common part of the Vec3<float> and Vec3<double>
+    specializations.
+    
+    Coordinates are stored in lanes 0 to 2 of a 4-lane
+    register, lane 3 is padding, kept null. Operators work on
+    the whole register; reductions (dot product, norms) add
+    lanes 0, 1 and 2 in this order, so that results are the
+    same as those of the generic Vec3.
+    
+    Declaration/Definition file: animal/geometry/vec3_simd.h
+    (creation date: October 19, 2026).
+    
+    @see Vec3 */
+//
+// -----------------------------------------------------
+
+template <class RealT, class NumTraitsT>
+
+class Vec3_Packed
+{
+
+public:
+
+  // Traits typedefs
+  typedef RealT Real;
+  typedef typename Vec3_Lanes<RealT>::Pack Pack;
+  typedef Vec3<RealT,NumTraitsT> Vec3_t;
+  
+  
+  /** @name Get */
+  //@{
+  const Real& x() const { return a[0]; }
+  const Real& y() const { return a[1]; }
+  const Real& z() const { return a[2]; }
+  const Real& operator[](int i) const { return a[i]; }
+  
+  /// The 4 lanes (lane 3 is null)
+  const Pack& lanes() const { return v; }
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  Vec3_t& setx(const Real x0) { a[0] = x0; return self(); }
+  Vec3_t& sety(const Real y0) { a[1] = y0; return self(); }
+  Vec3_t& setz(const Real z0) { a[2] = z0; return self(); }
+  Real& operator[](int i) { return a[i]; }
+  //@}
+  
+  
+  /** @name Assignment operators */
+  //@{
+  Vec3_t& operator+=(const Vec3_t& w) { v += w.v; return self(); }
+  Vec3_t& operator-=(const Vec3_t& w) { v -= w.v; return self(); }
+  Vec3_t& operator*=(const Real k) { v *= k; return self(); }
+  Vec3_t& operator/=(const Real k) { return (*this) *= 1.0/k; }
+  //@}
+  
+  
+  /** @name Arithmetic operators */
+  //@{
+  Vec3_t operator+(const Vec3_t& w) const { return Vec3_t(v + w.v); }
+  Vec3_t operator-(const Vec3_t& w) const { return Vec3_t(v - w.v); }
+  Vec3_t operator*(const Real k) const { return Vec3_t(v*k); }
+  Vec3_t operator/(const Real k) const { return (*this)*(1.0/k); }
+  Vec3_t operator-() { return Vec3_t(-v); }
+  //@}
+  
+  
+  /** @name Equality and relational operators */
+  //@{
+  bool operator==(const Vec3_t& w) const
+    { return ( (w.x() == a[0]) && (w.y() == a[1]) && (w.z() == a[2]) ); }
+  bool operator!=(const Vec3_t& w) const { return !operator==(w); }
+  //@}
+  
+  
+  /** @name Norms */
+  //@{
+  Real norm() const { return NumTraitsT::sqroot( sqnorm() ); }
+  Real sqnorm() const { return sum(v*v); }
+  Real inftNorm() const;
+  Vec3_t& normalize() { return (*this) *= 1.0/norm(); }
+  //@}
+  
+  
+  /** @name Constants */
+  //@{
+  static const Vec3_t null() { return Vec3_t( Real(0.0), Real(0.0), Real(0.0) ); }
+  //@}
+  
+  
+  /// Sum of lanes 0, 1 and 2
+  static Real sum(const Pack& p) { return p[0] + p[1] + p[2]; }
+
+
+
+protected:
+
+  Vec3_Packed() { a[3] = 0.0; }
+  Vec3_Packed(const Real x0, const Real y0, const Real z0)
+    { a[0] = x0; a[1] = y0; a[2] = z0; a[3] = 0.0; }
+  Vec3_Packed(const Pack& p) : v(p) {}
+
+
+
+private:
+
+  Vec3_t& self() { return static_cast<Vec3_t&>(*this); }
+  
+  union
+  {
+    Pack v;
+    Real a[4];
+  };
+
+}; // class Vec3_Packed
+
+
+
+/// Vec3 specialization for float, in a 4-lane register
+template <class NumTraitsT>
+
+class Vec3<float,NumTraitsT> : public Vec3_Packed<float,NumTraitsT>
+{
+
+  typedef Vec3_Packed<float,NumTraitsT> Base;
+
+public:
+
+  Vec3() {}
+  Vec3(const float x0, const float y0, const float z0) : Base(x0, y0, z0) {}
+  
+  template <class R, class NT>
+  explicit Vec3(const Vec3<R,NT>& w) : Base(w[0], w[1], w[2]) {}
+  
+  explicit Vec3(const typename Base::Pack& p) : Base(p) {}
+
+}; // class Vec3<float,NumTraitsT>
+
+
+
+#ifdef __AVX__
+/// Vec3 specialization for double, in a 4-lane register
+template <class NumTraitsT>
+
+class Vec3<double,NumTraitsT> : public Vec3_Packed<double,NumTraitsT>
+{
+
+  typedef Vec3_Packed<double,NumTraitsT> Base;
+
+public:
+
+  Vec3() {}
+  Vec3(const double x0, const double y0, const double z0) : Base(x0, y0, z0) {}
+  
+  template <class R, class NT>
+  explicit Vec3(const Vec3<R,NT>& w) : Base(w[0], w[1], w[2]) {}
+  
+  explicit Vec3(const typename Base::Pack& p) : Base(p) {}
+
+}; // class Vec3<double,NumTraitsT>
+#endif
+
+
+
+/** @name Dot and cross products (4 lanes) */
+//@{
+/// Dot product
+template <class NumTraitsT>
+float dot(const Vec3<float,NumTraitsT>& , const Vec3<float,NumTraitsT>& );
+
+#ifdef __AVX__
+template <class NumTraitsT>
+double dot(const Vec3<double,NumTraitsT>& , const Vec3<double,NumTraitsT>& );
+#endif
+
+/// Cross product
+template <class NumTraitsT>
+Vec3<float,NumTraitsT> cross(const Vec3<float,NumTraitsT>& , const Vec3<float,NumTraitsT>& );
+
+#ifdef __AVX__
+template <class NumTraitsT>
+Vec3<double,NumTraitsT> cross(const Vec3<double,NumTraitsT>& , const Vec3<double,NumTraitsT>& );
+#endif
+//@}
+
+/// Linear combination (see vec3.h)
+template <class NumTraitsT, class IndexT>
+Vec3<float,NumTraitsT> lincomb(int n, const float k[], const Vec3<float,NumTraitsT> x[], const IndexT i[]);
+
+#ifdef __AVX__
+template <class NumTraitsT, class IndexT>
+Vec3<double,NumTraitsT> lincomb(int n, const double k[], const Vec3<double,NumTraitsT> x[], const IndexT i[]);
+#endif
+
+} } // namespace animal { namespace geometry {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace geometry {
+
+template <class RealT, class NumTraitsT>
+inline RealT
+Vec3_Packed<RealT,NumTraitsT>::
+inftNorm() const
+{
+  Real x0 = a[0];
+  Real y0 = a[1];
+  Real z0 = a[2];
+  
+  if ( x0 < 0.0 ) x0 = -x0;
+  if ( y0 < 0.0 ) y0 = -y0;
+  if ( z0 < 0.0 ) z0 = -z0;
+  
+  Real max = x0;
+  
+  if ( max < y0 ) max = y0;
+  if ( max < z0 ) max = z0;
+  return max;
+}
+
+
+
+
+
+template <class NumTraitsT>
+inline float
+dot(const Vec3<float,NumTraitsT>& v1, const Vec3<float,NumTraitsT>& v2)
+{
+  return Vec3<float,NumTraitsT>::sum( v1.lanes()*v2.lanes() );
+}
+
+#ifdef __AVX__
+template <class NumTraitsT>
+inline double
+dot(const Vec3<double,NumTraitsT>& v1, const Vec3<double,NumTraitsT>& v2)
+{
+  return Vec3<double,NumTraitsT>::sum( v1.lanes()*v2.lanes() );
+}
+#endif
+
+// (y, z, x) and (z, x, y) permutations; lane 3 stays in place
+template <class RealT, class NumTraitsT>
+inline Vec3<RealT,NumTraitsT>
+cross_lanes(const Vec3<RealT,NumTraitsT>& v1, const Vec3<RealT,NumTraitsT>& v2)
+{
+  typedef typename Vec3_Lanes<RealT>::Pack Pack;
+  typedef typename Vec3_Lanes<RealT>::Mask Mask;
+  
+  const Mask yzx = { 1, 2, 0, 3 };
+  const Mask zxy = { 2, 0, 1, 3 };
+  
+  const Pack& p1 = v1.lanes();
+  const Pack& p2 = v2.lanes();
+  
+  return Vec3<RealT,NumTraitsT>( __builtin_shuffle(p1, yzx)*__builtin_shuffle(p2, zxy) -
+				 __builtin_shuffle(p1, zxy)*__builtin_shuffle(p2, yzx) );
+}
+
+template <class NumTraitsT>
+inline Vec3<float,NumTraitsT>
+cross(const Vec3<float,NumTraitsT>& v1, const Vec3<float,NumTraitsT>& v2)
+{
+  return cross_lanes(v1, v2);
+}
+
+#ifdef __AVX__
+template <class NumTraitsT>
+inline Vec3<double,NumTraitsT>
+cross(const Vec3<double,NumTraitsT>& v1, const Vec3<double,NumTraitsT>& v2)
+{
+  return cross_lanes(v1, v2);
+}
+#endif
+
+
+
+
+
+template <class RealT, class NumTraitsT, class IndexT>
+inline Vec3<RealT,NumTraitsT>
+lincomb_lanes(int n, const RealT k[], const Vec3<RealT,NumTraitsT> x[], const IndexT i[])
+{
+  typename Vec3_Lanes<RealT>::Pack s = k[0]*x[ i[0] ].lanes();
+  
+  for (int j = 1; j < n; ++j)
+    s += k[j]*x[ i[j] ].lanes();
+  
+  return Vec3<RealT,NumTraitsT>(s);
+}
+
+template <class NumTraitsT, class IndexT>
+inline Vec3<float,NumTraitsT>
+lincomb(int n, const float k[], const Vec3<float,NumTraitsT> x[], const IndexT i[])
+{
+  return lincomb_lanes(n, k, x, i);
+}
+
+#ifdef __AVX__
+template <class NumTraitsT, class IndexT>
+inline Vec3<double,NumTraitsT>
+lincomb(int n, const double k[], const Vec3<double,NumTraitsT> x[], const IndexT i[])
+{
+  return lincomb_lanes(n, k, x, i);
+}
+#endif
+
+} } // namespace animal { namespace geometry {
+
+
+
+#endif // ANIMAL_GEOMETRY_VEC3_SIMD_H
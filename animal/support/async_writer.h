@@ -0,0 +1,337 @@
+#ifndef ANIMAL_SUPPORT_ASYNC_WRITER_H
+#define ANIMAL_SUPPORT_ASYNC_WRITER_H
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Async_Writer class.
+/** Buffered file output written by a background thread.
+
+    Data are appended to a memory buffer; full buffers are
+    queued and written to the file by a background thread, so
+    that the caller never waits for the disk (unless more than
+    max_pending buffers are waiting, in which case it blocks
+    until one is written). Text (printf) and binary (write)
+    output may be mixed.
+    
+    Write errors (e.g. a full disk) are recorded by the writer
+    thread and returned by close(): the caller decides whether
+    the file may be used.
+    
+    Declaration/Definition file: animal/support/async_writer.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Async_Writer
+{
+
+public:
+
+  /** @name Constructors and destructor */
+  //@{
+  Async_Writer(std::size_t buffer_size = 1 << 16, std::size_t max_pending = 16);
+  
+  /// Flushes and closes the file
+  ~Async_Writer();
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Open name for writing and start the writer thread, false on error
+  bool open(const char* name, const char* mode = "w");
+  
+  /** Write remaining data, stop the writer thread and close the
+      file; false if any write failed since open() */
+  bool close();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True between open() and close()
+  bool isOpen() const { return is_open; }
+  
+  /// True when the queued buffers are written (see flush())
+  bool isWritten();
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /// Append size bytes
+  void write(const void* data, std::size_t size);
+  
+  /// Append formatted text
+  void printf(const char* format, ...);
+  
+  /// Queue the current buffer, even if not full
+  void flush();
+  //@}
+
+
+
+private:
+
+  typedef std::vector<char> Buffer;
+  
+  // Not copyable
+  Async_Writer(const Async_Writer&);
+  Async_Writer& operator=(const Async_Writer&);
+  
+  static void* run(void* writer);
+  
+  
+  std::FILE* file;
+  bool is_open;
+  bool failed; // a write failed, set by the writer thread
+  
+  std::size_t capacity;  // of each buffer
+  std::size_t max_queue; // of pending buffers
+  Buffer current;
+  
+  std::deque<Buffer*> pending;
+  std::vector<Buffer*> spare;
+  bool writing; // a buffer is being written
+  bool stop;
+  
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t not_empty, not_full;
+
+}; // class Async_Writer
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline
+Async_Writer::
+Async_Writer(std::size_t buffer_size, std::size_t max_pending)
+  : file(0), is_open(false), failed(false),
+    capacity(buffer_size), max_queue(max_pending),
+    writing(false), stop(false)
+{
+  current.reserve(capacity);
+  
+  pthread_mutex_init(&mutex, 0);
+  pthread_cond_init(&not_empty, 0);
+  pthread_cond_init(&not_full, 0);
+}
+
+inline
+Async_Writer::
+~Async_Writer()
+{
+  close();
+  
+  for (std::size_t i = 0; i < spare.size(); ++i)
+    delete spare[i];
+  
+  pthread_cond_destroy(&not_full);
+  pthread_cond_destroy(&not_empty);
+  pthread_mutex_destroy(&mutex);
+}
+
+inline bool
+Async_Writer::
+open(const char* name, const char* mode)
+{
+  close();
+  
+  file = std::fopen(name, mode);
+  if ( !file ) return false;
+  
+  failed = false;
+  stop = false;
+  if ( pthread_create(&thread, 0, run, this) )
+    {
+      std::fclose(file);
+      file = 0;
+      return false;
+    }
+  
+  is_open = true;
+  return true;
+}
+
+inline bool
+Async_Writer::
+close()
+{
+  if ( !is_open ) return true;
+  
+  flush();
+  
+  pthread_mutex_lock(&mutex);
+  stop = true;
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+  
+  pthread_join(thread, 0); // failed is set
+  
+  if ( std::fclose(file) ) failed = true;
+  file = 0;
+  is_open = false;
+  
+  return !failed;
+}
+
+
+
+
+
+inline bool
+Async_Writer::
+isWritten()
+{
+  pthread_mutex_lock(&mutex);
+  bool written = pending.empty() && !writing;
+  pthread_mutex_unlock(&mutex);
+  
+  return written;
+}
+
+inline void
+Async_Writer::
+write(const void* data, std::size_t size)
+{
+  const char* first = static_cast<const char*>(data);
+  
+  while ( size > 0 )
+    {
+      std::size_t n = capacity - current.size();
+      if ( n > size ) n = size;
+      
+      current.insert(current.end(), first, first + n);
+      first += n;
+      size -= n;
+      
+      if ( current.size() >= capacity ) flush();
+    }
+}
+
+inline void
+Async_Writer::
+printf(const char* format, ...)
+{
+  char line[1024];
+  
+  va_list args;
+  va_start(args, format);
+  int n = std::vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  
+  if ( n < 0 ) return;
+  if ( n >= static_cast<int>( sizeof(line) ) )
+    {
+      // Rare long line
+      std::vector<char> long_line(n + 1);
+      va_start(args, format);
+      std::vsnprintf(&long_line[0], n + 1, format, args);
+      va_end(args);
+      write(&long_line[0], n);
+      return;
+    }
+  
+  write(line, n);
+}
+
+inline void
+Async_Writer::
+flush()
+{
+  if ( current.empty() || !is_open ) return;
+  
+  pthread_mutex_lock(&mutex);
+  
+  while ( pending.size() >= max_queue )
+    pthread_cond_wait(&not_full, &mutex);
+  
+  Buffer* b;
+  if ( spare.empty() )
+    b = new Buffer;
+  else
+    {
+      b = spare.back();
+      spare.pop_back();
+    }
+  
+  b->swap(current);
+  pending.push_back(b);
+  
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+  
+  current.clear();
+  current.reserve(capacity);
+}
+
+inline void*
+Async_Writer::
+run(void* writer)
+{
+  Async_Writer& w = *static_cast<Async_Writer*>(writer);
+  
+  pthread_mutex_lock(&w.mutex);
+  
+  for (;;)
+    {
+      while ( w.pending.empty() && !w.stop )
+	pthread_cond_wait(&w.not_empty, &w.mutex);
+      
+      if ( w.pending.empty() ) break; // stopped, and everything written
+      
+      Buffer* b = w.pending.front();
+      w.pending.pop_front();
+      w.writing = true;
+      pthread_cond_signal(&w.not_full);
+      
+      // Write outside the lock
+      pthread_mutex_unlock(&w.mutex);
+      if ( std::fwrite(&(*b)[0], 1, b->size(), w.file) != b->size() )
+	w.failed = true;
+      b->clear();
+      pthread_mutex_lock(&w.mutex);
+      
+      w.spare.push_back(b);
+      w.writing = false;
+    }
+  
+  pthread_mutex_unlock(&w.mutex);
+  
+  if ( std::fflush(w.file) ) w.failed = true;
+  return 0;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_ASYNC_WRITER_H
@@ -0,0 +1,256 @@
+#ifndef ANIMAL_SUPPORT_CAMERA_SCRIPT_H
+#define ANIMAL_SUPPORT_CAMERA_SCRIPT_H
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Camera_Script class.
+/** Scripted camera, driving a Trackball over time.
+
+    A script is a text file of key frames, one per line:
+    
+      t  ax ay az angle  tx ty tz
+    
+    date t (in s), rotation axis and angle (in degrees) and
+    translation, as given to Trackball::setTransf(). Key frames
+    must be sorted by date. Between two key frames, rotations
+    are interpolated by slerp and translations linearly; before
+    the first and after the last, the camera does not move.
+    Empty lines and lines starting with '#' are skipped.
+    
+    Trackball_t is a Trackball instance (see trackball.h).
+    
+    Declaration/Definition file: animal/support/camera_script.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+template <class Trackball_t>
+
+class Camera_Script
+{
+
+public:
+
+  // Traits typedefs
+  typedef typename Trackball_t::Real_t Real_t;
+  typedef typename Trackball_t::Vec3_t Vec3_t;
+  typedef typename Trackball_t::Quat_t Quat_t;
+  
+  
+  /** @name Constructor */
+  //@{
+  Camera_Script()
+    {}
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Read key frames from file name, false on error
+  bool read(const char* name);
+  
+  /// Append a key frame (dates must increase)
+  void add(Real_t t, const Quat_t& r, const Vec3_t& tr);
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True if there is no key frame
+  bool empty() const { return keys.empty(); }
+  
+  /// Number of key frames
+  int size() const { return keys.size(); }
+  
+  /// Camera at date t
+  void at(Real_t t, Quat_t& r, Vec3_t& tr) const;
+  //@}
+  
+  
+  /** @name Motion */
+  //@{
+  /// Set the trackball to the camera at date t (if not empty)
+  void apply(Trackball_t& tb, Real_t t) const;
+  //@}
+
+
+
+private:
+
+  struct Key
+  {
+    Real_t t;
+    Quat_t rot;
+    Vec3_t transl;
+  };
+  
+  // Spherical linear interpolation, along the shortest arc
+  static Quat_t slerp(const Quat_t& q0, const Quat_t& q1, Real_t u);
+  
+  
+  std::vector<Key> keys;
+
+}; // class Camera_Script
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+template <class Trackball_t>
+inline bool
+Camera_Script<Trackball_t>::
+read(const char* name)
+{
+  std::ifstream file_in(name);
+  if ( !file_in ) return false;
+  
+  keys.clear();
+  
+  char line[256];
+  
+  while ( file_in.getline(line, 256, '\n') )
+    {
+      double t, ax, ay, az, angle, tx, ty, tz;
+      
+      if ( line[0] == '#' ) continue;
+      
+      int n = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf",
+		     &t, &ax, &ay, &az, &angle, &tx, &ty, &tz);
+      
+      if ( n <= 0 ) continue;  // empty line
+      if ( n != 8 ) return false;
+      
+      add( t, Quat_t( Vec3_t(ax, ay, az), angle*M_PI/180.0 ), Vec3_t(tx, ty, tz) );
+    }
+  
+  return true;
+}
+
+template <class Trackball_t>
+inline void
+Camera_Script<Trackball_t>::
+add(Real_t t, const Quat_t& r, const Vec3_t& tr)
+{
+  Key k;
+  k.t = t;
+  k.rot = r;
+  k.transl = tr;
+  
+  keys.push_back(k);
+}
+
+template <class Trackball_t>
+inline void
+Camera_Script<Trackball_t>::
+at(Real_t t, Quat_t& r, Vec3_t& tr) const
+{
+  if ( t <= keys.front().t )
+    {
+      r = keys.front().rot;
+      tr = keys.front().transl;
+      return;
+    }
+  
+  if ( t >= keys.back().t )
+    {
+      r = keys.back().rot;
+      tr = keys.back().transl;
+      return;
+    }
+  
+  // First key after t (scripts are short)
+  unsigned int i = 1;
+  while ( keys[i].t <= t ) ++i;
+  
+  const Key& k0 = keys[i - 1];
+  const Key& k1 = keys[i];
+  
+  Real_t u = (t - k0.t)/(k1.t - k0.t);
+  
+  r = slerp(k0.rot, k1.rot, u);
+  tr = (1.0 - u)*k0.transl + u*k1.transl;
+}
+
+template <class Trackball_t>
+inline void
+Camera_Script<Trackball_t>::
+apply(Trackball_t& tb, Real_t t) const
+{
+  if ( keys.empty() ) return;
+  
+  Quat_t r;
+  Vec3_t tr;
+  
+  at(t, r, tr);
+  tb.setTransf(r, tr);
+}
+
+template <class Trackball_t>
+inline typename Camera_Script<Trackball_t>::Quat_t
+Camera_Script<Trackball_t>::
+slerp(const Quat_t& q0, const Quat_t& q1, Real_t u)
+{
+  Real_t c = q0.w()*q1.w() + q0.x()*q1.x() + q0.y()*q1.y() + q0.z()*q1.z();
+  Real_t s1 = 1.0;
+  
+  if ( c < 0.0 ) // q and -q are the same rotation
+    {
+      c = -c;
+      s1 = -1.0;
+    }
+  
+  Real_t w0, w1;
+  
+  if ( c > 0.9995 ) // nearly equal, linear is accurate enough
+    {
+      w0 = 1.0 - u;
+      w1 = u;
+    }
+  else
+    {
+      Real_t a = acos(c);
+      Real_t s = sin(a);
+      
+      w0 = sin( (1.0 - u)*a )/s;
+      w1 = sin( u*a )/s;
+    }
+  
+  w1 *= s1;
+  
+  Quat_t q( w0*q0.w() + w1*q1.w(),
+	    w0*q0.x() + w1*q1.x(),
+	    w0*q0.y() + w1*q1.y(),
+	    w0*q0.z() + w1*q1.z() );
+  
+  return q.normalize();
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_CAMERA_SCRIPT_H
@@ -0,0 +1,482 @@
+#ifndef ANIMAL_SUPPORT_CHECKPOINT_H
+#define ANIMAL_SUPPORT_CHECKPOINT_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <animal/support/async_writer.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+/** @name Checkpoint file format
+
+    A header, a table of sections, then the sections, each one
+    an array of fixed size elements copied as they are in
+    memory (elements must be copyable with memcpy). Sections
+    start on page boundaries, so that a mapped file can be used
+    in place, or a single section mapped.
+    
+    The byte order, the format version and, for each section,
+    the element size are checked when reading: a file is only
+    read back by a program built with the same data layout.
+    The tag names the program that wrote the file.
+    
+    Declaration/Definition file: animal/support/checkpoint.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+//@{
+
+struct Checkpoint_Header
+{
+  char magic[8];      // "ANIMCKPT"
+  uint32_t order;     // 0x01020304, as written
+  uint32_t version;   // of the format
+  char tag[48];       // writer program
+  uint64_t size;      // of the file, in bytes
+  uint32_t nsections;
+  uint32_t reserved;
+};
+
+struct Checkpoint_Section
+{
+  char name[24];
+  uint32_t elem_size; // in bytes
+  uint32_t reserved;
+  uint64_t count;     // of elements
+  uint64_t offset;    // from the beginning of the file
+};
+
+//@}
+
+
+
+// ----------------------------------------------------------
+//
+//  Checkpoint_Writer class.
+/** Writer of checkpoint files, in the background.
+
+    Sections are listed by add(), then write() copies them in
+    the buffers of an Async_Writer and returns: the copy is the
+    snapshot, the caller may go on modifying the data while the
+    file is written by another thread. The file is written as
+    name.tmp, renamed to name once complete (see poll()), so
+    that an interrupted write never replaces the previous
+    checkpoint; a failed one (e.g. a full disk) is reported and
+    name.tmp removed.
+    
+    Declaration/Definition file: animal/support/checkpoint.h
+    (creation date: October 19, 2026).
+    
+    @see Checkpoint_Reader, Async_Writer */
+//
+// ----------------------------------------------------------
+
+class Checkpoint_Writer
+{
+
+public:
+
+  /// Current version of the format
+  static uint32_t version() { return 1; }
+  
+  /// Alignment of the sections
+  static uint64_t alignment() { return 4096; }
+  
+  
+  /** @name Constructor and destructor */
+  //@{
+  /// Pending buffers are not limited: write() never waits for the disk
+  Checkpoint_Writer() : out(1 << 20, std::size_t(-1))
+    {}
+  
+  /// Waits for the last checkpoint (see close())
+  ~Checkpoint_Writer() { close(); }
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Add a section of n elements, to be copied by the next write()
+  template <class T>
+  void add(const char* name, const T* data, std::size_t n);
+  
+  /// Add a section made of the elements of v
+  template <class T>
+  void add(const char* name, const std::vector<T>& v)
+    { add(name, v.empty() ? 0 : &v[0], v.size()); }
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /** Copy the added sections, and write them to name in the
+      background; waits for the previous checkpoint if it is not
+      written yet. False if the file cannot be opened. */
+  bool write(const char* name, const char* tag);
+  
+  /** If the last checkpoint is written, rename it (see close());
+      true if it is done */
+  bool poll();
+  
+  /** Wait for the last checkpoint, and rename it; false (with a
+      message) if it could not be written, the previous one being
+      kept */
+  bool close();
+  //@}
+
+
+
+private:
+
+  struct Entry
+  {
+    Checkpoint_Section section;
+    const void* data;
+  };
+  
+  // Not copyable
+  Checkpoint_Writer(const Checkpoint_Writer&);
+  Checkpoint_Writer& operator=(const Checkpoint_Writer&);
+  
+  
+  std::vector<Entry> entries;
+  
+  Async_Writer out;
+  std::string file_name; // of the checkpoint being written
+
+}; // class Checkpoint_Writer
+
+
+
+// ----------------------------------------------------------
+//
+//  Checkpoint_Reader class.
+/** Reader of checkpoint files, mapped in memory.
+
+    read() copies a section into an array; data() gives the
+    address of a section in the mapping, valid until close().
+    Both fail (false, or null) if the section is missing, or if
+    its element size is not the expected one.
+    
+    Declaration/Definition file: animal/support/checkpoint.h
+    (creation date: October 19, 2026).
+    
+    @see Checkpoint_Writer */
+//
+// ----------------------------------------------------------
+
+class Checkpoint_Reader
+{
+
+public:
+
+  /** @name Constructor and destructor */
+  //@{
+  Checkpoint_Reader() : map(0), map_size(0)
+    {}
+  ~Checkpoint_Reader() { close(); }
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Map name and check its header, false (with a message) on error
+  bool open(const char* name);
+  
+  /// Unmap the file
+  void close();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// Writer program
+  const char* tag() const { return header().tag; }
+  
+  /// Mapped section of elements of elem_size bytes, and their number
+  const void* data(const char* name, std::size_t elem_size, std::size_t& n) const;
+  
+  /// Copy the n elements of a section of exactly n elements
+  template <class T>
+  bool read(const char* name, T* data, std::size_t n) const;
+  
+  /// Copy a section into v
+  template <class T>
+  bool read(const char* name, std::vector<T>& v) const;
+  //@}
+
+
+
+private:
+
+  const Checkpoint_Header& header() const
+    { return *static_cast<const Checkpoint_Header*>(map); }
+  
+  bool failed(const char* name, const char* what)
+    {
+      std::fprintf(stderr, "Checkpoint %s: %s\n", name, what);
+      close();
+      return false;
+    }
+  
+  // Not copyable
+  Checkpoint_Reader(const Checkpoint_Reader&);
+  Checkpoint_Reader& operator=(const Checkpoint_Reader&);
+  
+  
+  void* map;
+  std::size_t map_size;
+
+}; // class Checkpoint_Reader
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+template <class T>
+inline void
+Checkpoint_Writer::
+add(const char* name, const T* data, std::size_t n)
+{
+  Entry e;
+  std::memset(&e.section, 0, sizeof(e.section));
+  std::strncpy(e.section.name, name, sizeof(e.section.name) - 1);
+  e.section.elem_size = sizeof(T);
+  e.section.count = n;
+  e.data = data;
+  
+  entries.push_back(e);
+}
+
+inline bool
+Checkpoint_Writer::
+write(const char* name, const char* tag)
+{
+  close();
+  
+  const uint64_t a = alignment();
+  
+  // Layout
+  Checkpoint_Header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "ANIMCKPT", 8);
+  h.order = 0x01020304;
+  h.version = version();
+  std::strncpy(h.tag, tag, sizeof(h.tag) - 1);
+  h.nsections = entries.size();
+  
+  uint64_t offset = sizeof(h) + entries.size()*sizeof(Checkpoint_Section);
+  
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+      Checkpoint_Section& s = entries[i].section;
+      
+      s.offset = (offset + a - 1)/a*a;
+      offset = s.offset + s.count*s.elem_size;
+    }
+  
+  h.size = offset;
+  
+  // Snapshot
+  file_name = name;
+  if ( !out.open( (file_name + ".tmp").c_str(), "wb" ) )
+    {
+      entries.clear();
+      return false;
+    }
+  
+  out.write(&h, sizeof(h));
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    out.write(&entries[i].section, sizeof(Checkpoint_Section));
+  
+  offset = sizeof(h) + entries.size()*sizeof(Checkpoint_Section);
+  
+  const std::vector<char> zeros(a, 0);
+  
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+      const Checkpoint_Section& s = entries[i].section;
+      
+      out.write(&zeros[0], s.offset - offset); // padding
+      out.write(entries[i].data, s.count*s.elem_size);
+      offset = s.offset + s.count*s.elem_size;
+    }
+  
+  out.flush();
+  entries.clear();
+  
+  return true;
+}
+
+inline bool
+Checkpoint_Writer::
+poll()
+{
+  if ( !out.isOpen() ) return true;
+  if ( !out.isWritten() ) return false;
+  
+  close();
+  return true;
+}
+
+inline bool
+Checkpoint_Writer::
+close()
+{
+  if ( !out.isOpen() ) return true;
+  
+  const std::string tmp = file_name + ".tmp";
+  
+  if ( !out.close() || std::rename( tmp.c_str(), file_name.c_str() ) )
+    {
+      std::fprintf(stderr, "Checkpoint %s: write failed, previous checkpoint kept\n",
+		   file_name.c_str());
+      std::remove( tmp.c_str() );
+      return false;
+    }
+  
+  return true;
+}
+
+
+
+
+
+inline bool
+Checkpoint_Reader::
+open(const char* name)
+{
+  close();
+  
+  int fd = ::open(name, O_RDONLY);
+  if ( fd < 0 ) return failed(name, "cannot open file");
+  
+  struct stat st;
+  if ( fstat(fd, &st) || st.st_size < static_cast<off_t>( sizeof(Checkpoint_Header) ) )
+    {
+      ::close(fd);
+      return failed(name, "not a checkpoint");
+    }
+  
+  map_size = st.st_size;
+  map = mmap(0, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  
+  if ( map == MAP_FAILED )
+    {
+      map = 0;
+      return failed(name, "cannot map file");
+    }
+  
+  const Checkpoint_Header& h = header();
+  
+  if ( std::memcmp(h.magic, "ANIMCKPT", 8) ) return failed(name, "not a checkpoint");
+  if ( h.order != 0x01020304 ) return failed(name, "other byte order");
+  if ( h.version != Checkpoint_Writer::version() ) return failed(name, "other format version");
+  if ( h.size != map_size ) return failed(name, "truncated file");
+  
+  if ( sizeof(h) + h.nsections*sizeof(Checkpoint_Section) > map_size )
+    return failed(name, "truncated file");
+  
+  const Checkpoint_Section* s =
+    reinterpret_cast<const Checkpoint_Section*>( static_cast<const char*>(map) + sizeof(h) );
+  
+  for (uint32_t i = 0; i < h.nsections; ++i)
+    if ( s[i].offset + s[i].count*s[i].elem_size > map_size )
+      return failed(name, "truncated file");
+  
+  return true;
+}
+
+inline void
+Checkpoint_Reader::
+close()
+{
+  if ( !map ) return;
+  
+  munmap(map, map_size);
+  map = 0;
+  map_size = 0;
+}
+
+inline const void*
+Checkpoint_Reader::
+data(const char* name, std::size_t elem_size, std::size_t& n) const
+{
+  if ( !map ) return 0;
+  
+  const char* first = static_cast<const char*>(map);
+  const Checkpoint_Section* s =
+    reinterpret_cast<const Checkpoint_Section*>( first + sizeof(Checkpoint_Header) );
+  
+  for (uint32_t i = 0; i < header().nsections; ++i)
+    if ( !std::strncmp(s[i].name, name, sizeof(s[i].name)) )
+      {
+	if ( s[i].elem_size != elem_size ) return 0;
+	
+	n = s[i].count;
+	return first + s[i].offset;
+      }
+  
+  return 0;
+}
+
+template <class T>
+inline bool
+Checkpoint_Reader::
+read(const char* name, T* data, std::size_t n) const
+{
+  std::size_t m;
+  const void* p = this->data(name, sizeof(T), m);
+  
+  if ( !p || m != n ) return false;
+  
+  std::memcpy(data, p, n*sizeof(T));
+  return true;
+}
+
+template <class T>
+inline bool
+Checkpoint_Reader::
+read(const char* name, std::vector<T>& v) const
+{
+  std::size_t n;
+  const T* first = static_cast<const T*>( data(name, sizeof(T), n) ); // aligned
+  
+  if ( !first ) return false;
+  
+  v.assign(first, first + n);
+  return true;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_CHECKPOINT_H
@@ -0,0 +1,507 @@
+#ifndef ANIMAL_SUPPORT_PERF_COUNTERS_H
+#define ANIMAL_SUPPORT_PERF_COUNTERS_H
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Perf_Counters class.
+/** Hardware performance counter sampling of code regions.
+
+    Cycles, instructions, L1 data cache read misses, last level
+    cache misses and branch misses are read through Linux
+    perf_event_open around named regions (see Perf_Scope).
+    Each region accumulates counter deltas, calls and the number
+    of items (elements, particles...) processed, so that the
+    report can give counts per item.
+    
+    Counters are opened for the thread calling enable(), and
+    for the threads calling attach() (the workers of the solver
+    passes, see parallelize() in scheme.h): a region counts the
+    sum over all of them, so that the counts of a parallel pass
+    are divided by all its items. Workers waiting for a task
+    spin a little before sleeping, which is counted too.
+    
+    Only the thread calling enable() records regions: scopes
+    entered by other threads (the members of an ensemble, or
+    scopes inside the tasks of the workers) are not counted.
+    region() may be called from any thread.
+    
+    When the kernel refuses a counter (no PMU in a virtual
+    machine, restrictive perf_event_paranoid...) it is reported
+    as unavailable and the region still records calls, items
+    and elapsed time.
+    
+    Declaration/Definition file: animal/support/perf_counters.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Perf_Counters
+{
+
+public:
+
+  // Traits typedef
+  typedef unsigned long long Count_t;
+  
+  enum counter { CYCLES = 0, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES,
+		 NCOUNTERS };
+  
+  enum { MAX_REGIONS = 32, MAX_THREADS = 64 };
+  
+  
+  /// Counters shared by the whole program
+  static Perf_Counters& instance();
+  
+  
+  /** @name Set */
+  //@{
+  /** Open the counters and start recording; the report is printed
+      at exit and written in prefix.perf.csv */
+  void enable(const char* prefix);
+  
+  /** Open the counters of the calling thread too, added to those
+      of the regions (after enable(), before recording) */
+  void attach();
+  
+  /// Register a region name, with the item it is normalized by
+  int region(const char* name, const char* item);
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True when regions record
+  bool enabled() const { return is_enabled; }
+  
+  /// True when regions record on the calling thread
+  bool recording() const
+    { return is_enabled && pthread_equal(pthread_self(), owner); }
+  
+  /// True when counter c could be opened
+  bool available(counter c) const { return fd[0][c] >= 0; }
+  
+  /// Counter name
+  static const char* name(counter c);
+  //@}
+  
+  
+  /** @name Recording (use Perf_Scope instead) */
+  //@{
+  /// Read every counter (and the clock) in values[NCOUNTERS + 1]
+  void read(Count_t values[]) const;
+  
+  /// Add counts read since start to region id
+  void add(int id, const Count_t start[], unsigned long items);
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /// Print per-region counts, per call and per item
+  void report(std::FILE* f) const;
+  
+  /// Write per-region counts in CSV format
+  void writeCSV(std::FILE* f) const;
+  //@}
+
+
+
+private:
+
+  struct Region
+  {
+    const char* name;
+    const char* item;
+    Count_t calls, items;
+    Count_t counts[NCOUNTERS + 1]; // last one is time in ns
+  };
+  
+  Perf_Counters();
+  
+  // Counters of the calling thread in fd[t]
+  void open(int t);
+  static void reportAtExit();
+  
+  
+  bool is_enabled;
+  pthread_t owner; // thread that called enable()
+  char file_prefix[256];
+  
+  int fd[MAX_THREADS][NCOUNTERS];
+  pthread_t threads[MAX_THREADS];
+  int nthreads;
+  int open_errno;
+  
+  pthread_mutex_t mutex; // of region() and attach()
+  
+  Region regions[MAX_REGIONS];
+  int nregions;
+
+}; // class Perf_Counters
+
+
+
+// ----------------------------------------------------------
+//
+//  Perf_Scope class.
+/** Counts the enclosing scope in region id, for n items.
+
+    Declaration/Definition file: animal/support/perf_counters.h
+    (creation date: October 19, 2026).
+    
+    @see Perf_Counters */
+//
+// ----------------------------------------------------------
+
+class Perf_Scope
+{
+
+public:
+
+  Perf_Scope(int id, unsigned long n)
+    : region_id(id), items(n),
+      is_active( Perf_Counters::instance().recording() )
+    {
+      if ( is_active ) Perf_Counters::instance().read(start);
+    }
+  ~Perf_Scope()
+    {
+      if ( is_active ) Perf_Counters::instance().add(region_id, start, items);
+    }
+
+private:
+
+  int region_id;
+  unsigned long items;
+  bool is_active;
+  Perf_Counters::Count_t start[Perf_Counters::NCOUNTERS + 1];
+
+}; // class Perf_Scope
+
+} } // namespace animal { namespace support {
+
+
+
+/** Count the enclosing scope as region name (a string literal),
+    normalized by n items of kind item (a string literal). */
+#define ANIMAL_PERF_SCOPE(name, item, n) \
+  ANIMAL_PERF_SCOPE_AT(name, item, n, __LINE__)
+  
+#define ANIMAL_PERF_SCOPE_AT(name, item, n, line) \
+  ANIMAL_PERF_SCOPE_AT_(name, item, n, line)
+  
+#define ANIMAL_PERF_SCOPE_AT_(name, item, n, line)                       \
+  static const int animal_perf_region_##line =                           \
+    animal::support::Perf_Counters::instance().region(name, item);       \
+  animal::support::Perf_Scope                                            \
+    animal_perf_scope_##line(animal_perf_region_##line, (n))
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline
+Perf_Counters::
+Perf_Counters()
+  : is_enabled(false), owner(), nthreads(0), open_errno(0), nregions(0)
+{
+  file_prefix[0] = '\0';
+  
+  for (int t = 0; t < MAX_THREADS; ++t)
+    for (int c = 0; c < NCOUNTERS; ++c)
+      fd[t][c] = -1;
+  
+  std::memset(regions, 0, sizeof(regions));
+  
+  pthread_mutex_init(&mutex, 0);
+}
+
+inline Perf_Counters&
+Perf_Counters::
+instance()
+{
+  static Perf_Counters counters; // Never deleted!
+  return counters;
+}
+
+inline const char*
+Perf_Counters::
+name(counter c)
+{
+  static const char* names[NCOUNTERS] =
+    { "cycles", "instructions", "L1d_misses", "LLC_misses", "branch_misses" };
+  return names[c];
+}
+
+
+
+
+
+inline void
+Perf_Counters::
+open(int t)
+{
+#ifdef __linux__
+  const unsigned int types[NCOUNTERS] =
+    {
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+  const unsigned long long configs[NCOUNTERS] =
+    {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_L1D
+	| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+	| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+  
+  for (int c = 0; c < NCOUNTERS; ++c)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = types[c];
+      attr.config = configs[c];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      
+      // This thread, any cpu
+      fd[t][c] = static_cast<int>( syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0) );
+      if ( fd[t][c] < 0 )
+	open_errno = errno;
+    }
+#else
+  open_errno = ENOSYS;
+#endif
+  
+  threads[t] = pthread_self();
+  
+  if ( open_errno && t == 0 )
+    std::fprintf(stderr, "Perf counters: some counters unavailable (%s), "
+		 "falling back to time measurement for them\n",
+		 std::strerror(open_errno));
+}
+
+inline void
+Perf_Counters::
+enable(const char* prefix)
+{
+  if ( !is_enabled )
+    {
+      owner = pthread_self();
+      open(nthreads++);
+      std::atexit(reportAtExit);
+    }
+  
+  std::strncpy(file_prefix, prefix, sizeof(file_prefix) - 1);
+  file_prefix[sizeof(file_prefix) - 1] = '\0';
+  
+  is_enabled = true;
+}
+
+inline void
+Perf_Counters::
+attach()
+{
+  pthread_mutex_lock(&mutex);
+  
+  bool known = false;
+  for (int t = 0; t < nthreads; ++t)
+    known = known || pthread_equal(threads[t], pthread_self());
+  
+  if ( is_enabled && !known && nthreads < MAX_THREADS )
+    open(nthreads++);
+  
+  pthread_mutex_unlock(&mutex);
+}
+
+inline int
+Perf_Counters::
+region(const char* name, const char* item)
+{
+  pthread_mutex_lock(&mutex);
+  
+  int id;
+  for (id = 0; id < nregions; ++id)
+    if ( !std::strcmp(regions[id].name, name) ) break;
+  
+  if ( id == nregions && nregions < MAX_REGIONS )
+    {
+      regions[nregions].name = name;
+      regions[nregions].item = item;
+      ++nregions;
+    }
+  
+  if ( id == MAX_REGIONS ) id = MAX_REGIONS - 1; // Overflow: share last one
+  
+  pthread_mutex_unlock(&mutex);
+  
+  return id;
+}
+
+
+
+
+
+inline void
+Perf_Counters::
+read(Count_t values[]) const
+{
+  for (int c = 0; c < NCOUNTERS; ++c)
+    {
+      values[c] = 0;
+      
+      // value, time enabled, time running: scale when the kernel
+      // multiplexes more counters than the PMU has
+      for (int t = 0; t < nthreads; ++t)
+	{
+	  Count_t v[3];
+	  if ( fd[t][c] >= 0 && ::read(fd[t][c], v, sizeof(v)) == sizeof(v) && v[2] )
+	    values[c] += v[2] == v[1] ? v[0]
+	      : static_cast<Count_t>( static_cast<double>(v[0])*v[1]/v[2] );
+	}
+    }
+  
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  values[NCOUNTERS] = static_cast<Count_t>(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+}
+
+inline void
+Perf_Counters::
+add(int id, const Count_t start[], unsigned long items)
+{
+  Count_t stop[NCOUNTERS + 1];
+  read(stop);
+  
+  Region& r = regions[id];
+  ++r.calls;
+  r.items += items;
+  
+  for (int c = 0; c <= NCOUNTERS; ++c)
+    r.counts[c] += stop[c] - start[c];
+}
+
+
+
+
+
+inline void
+Perf_Counters::
+report(std::FILE* f) const
+{
+  std::fprintf(f, "Performance counters (per item):\n");
+  
+  for (int id = 0; id < nregions; ++id)
+    {
+      const Region& r = regions[id];
+      if ( r.calls == 0 ) continue;
+      
+      double n = r.items ? static_cast<double>(r.items) : 1.0;
+      
+      std::fprintf(f, "  %-22s %10llu calls %12llu %-9s %9.3g ns/%s",
+		   r.name, r.calls, r.items, r.item,
+		   r.counts[NCOUNTERS]/n, r.item);
+      
+      for (int c = 0; c < NCOUNTERS; ++c)
+	if ( available( static_cast<counter>(c) ) )
+	  std::fprintf(f, " %9.3g %s", r.counts[c]/n, name( static_cast<counter>(c) ));
+      
+      if ( available(CYCLES) && available(INSTRUCTIONS) && r.counts[CYCLES] )
+	std::fprintf(f, " (IPC %.2f)",
+		     static_cast<double>(r.counts[INSTRUCTIONS])/r.counts[CYCLES]);
+      
+      std::fprintf(f, "\n");
+    }
+}
+
+inline void
+Perf_Counters::
+writeCSV(std::FILE* f) const
+{
+  std::fprintf(f, "region,item,calls,items,time_ns");
+  for (int c = 0; c < NCOUNTERS; ++c)
+    std::fprintf(f, ",%s", name( static_cast<counter>(c) ));
+  std::fprintf(f, "\n");
+  
+  for (int id = 0; id < nregions; ++id)
+    {
+      const Region& r = regions[id];
+      if ( r.calls == 0 ) continue;
+      
+      std::fprintf(f, "%s,%s,%llu,%llu,%llu",
+		   r.name, r.item, r.calls, r.items, r.counts[NCOUNTERS]);
+      
+      // Unavailable counters are left empty, not 0
+      for (int c = 0; c < NCOUNTERS; ++c)
+	if ( available( static_cast<counter>(c) ) )
+	  std::fprintf(f, ",%llu", r.counts[c]);
+	else
+	  std::fprintf(f, ",");
+      
+      std::fprintf(f, "\n");
+    }
+}
+
+inline void
+Perf_Counters::
+reportAtExit()
+{
+  Perf_Counters& p = instance();
+  
+  p.report(stdout);
+  
+  if ( p.file_prefix[0] )
+    {
+      char name[300];
+      std::sprintf(name, "%s.perf.csv", p.file_prefix);
+      
+      std::FILE* f = std::fopen(name, "w");
+      if ( !f )
+	{
+	  std::fprintf(stderr, "Perf counters: cannot open output file %s\n", name);
+	  return;
+	}
+      p.writeCSV(f);
+      std::fclose(f);
+    }
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_PERF_COUNTERS_H
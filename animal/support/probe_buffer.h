@@ -0,0 +1,270 @@
+#ifndef ANIMAL_SUPPORT_PROBE_BUFFER_H
+#define ANIMAL_SUPPORT_PROBE_BUFFER_H
+
+#include <cstdio>
+#include <vector>
+#include <pthread.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Probe_Buffer class.
+/** Samples of a few values, e.g. positions of observed
+    particles, taken at each step and written as text by a
+    background thread.
+    
+    Records (a date and width values) are stored in a ring of
+    capacity records, allocated by open(): record() gives the
+    next free slot, push() hands it to the writer thread, which
+    formats it as lines of a date and columns values. The
+    caller only copies the values; it waits if the ring is full.
+    
+    Declaration/Definition file: animal/support/probe_buffer.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Probe_Buffer
+{
+
+public:
+
+  /** @name Constructors and destructor */
+  //@{
+  Probe_Buffer(std::size_t capacity = 1024);
+  
+  /// Writes the remaining records and closes the file
+  ~Probe_Buffer();
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /** Open name for records of width values, written columns
+      values per line after a header line, and start the writer
+      thread; false on error */
+  bool open(const char* name, std::size_t width, std::size_t columns, const char* header);
+  
+  /// Write the remaining records, stop the writer thread and close the file
+  void close();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True between open() and close()
+  bool isOpen() const { return is_open; }
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /// Slot of the next record, width values to be set
+  double* record(double date);
+  
+  /// Queue the record returned by the last record() call
+  void push();
+  //@}
+
+
+
+private:
+
+  // Not copyable
+  Probe_Buffer(const Probe_Buffer&);
+  Probe_Buffer& operator=(const Probe_Buffer&);
+  
+  static void* run(void* buffer);
+  
+  double* slot(std::size_t i) { return &ring[i*(nvalues + 1)]; }
+  
+  
+  std::FILE* file;
+  bool is_open;
+  
+  std::size_t nvalues; // per record
+  std::size_t ncolumns; // per line
+  std::size_t nrecords; // in the ring
+  
+  std::vector<double> ring; // date and values of each record
+  std::size_t head;  // next slot to fill
+  std::size_t count; // records pushed, not written yet
+  bool stop;
+  
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t not_empty, not_full;
+
+}; // class Probe_Buffer
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline
+Probe_Buffer::
+Probe_Buffer(std::size_t capacity)
+  : file(0), is_open(false),
+    nvalues(0), ncolumns(1), nrecords(capacity),
+    head(0), count(0), stop(false)
+{
+  pthread_mutex_init(&mutex, 0);
+  pthread_cond_init(&not_empty, 0);
+  pthread_cond_init(&not_full, 0);
+}
+
+inline
+Probe_Buffer::
+~Probe_Buffer()
+{
+  close();
+  
+  pthread_cond_destroy(&not_full);
+  pthread_cond_destroy(&not_empty);
+  pthread_mutex_destroy(&mutex);
+}
+
+inline bool
+Probe_Buffer::
+open(const char* name, std::size_t width, std::size_t columns, const char* header)
+{
+  close();
+  
+  file = std::fopen(name, "w");
+  if ( !file ) return false;
+  
+  std::fprintf(file, "%s\n", header);
+  
+  nvalues = width;
+  ncolumns = columns;
+  ring.assign(nrecords*(nvalues + 1), 0.0);
+  head = count = 0;
+  
+  stop = false;
+  if ( pthread_create(&thread, 0, run, this) )
+    {
+      std::fclose(file);
+      file = 0;
+      return false;
+    }
+  
+  is_open = true;
+  return true;
+}
+
+inline void
+Probe_Buffer::
+close()
+{
+  if ( !is_open ) return;
+  
+  pthread_mutex_lock(&mutex);
+  stop = true;
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+  
+  pthread_join(thread, 0);
+  
+  std::fclose(file);
+  file = 0;
+  is_open = false;
+}
+
+
+
+
+
+inline double*
+Probe_Buffer::
+record(double date)
+{
+  pthread_mutex_lock(&mutex);
+  
+  while ( count == nrecords )
+    pthread_cond_wait(&not_full, &mutex);
+  
+  pthread_mutex_unlock(&mutex);
+  
+  double* r = slot(head);
+  r[0] = date;
+  return r + 1;
+}
+
+inline void
+Probe_Buffer::
+push()
+{
+  pthread_mutex_lock(&mutex);
+  
+  head = (head + 1) % nrecords;
+  ++count;
+  
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+}
+
+inline void*
+Probe_Buffer::
+run(void* buffer)
+{
+  Probe_Buffer& b = *static_cast<Probe_Buffer*>(buffer);
+  
+  pthread_mutex_lock(&b.mutex);
+  
+  for (;;)
+    {
+      while ( b.count == 0 && !b.stop )
+	pthread_cond_wait(&b.not_empty, &b.mutex);
+      
+      if ( b.count == 0 ) break; // stopped, and everything written
+      
+      std::size_t tail = (b.head + b.nrecords - b.count) % b.nrecords;
+      
+      // Format outside the lock: the slot is not reused before count decreases
+      pthread_mutex_unlock(&b.mutex);
+      
+      const double* r = b.slot(tail);
+      
+      for (std::size_t i = 0; i < b.nvalues; i += b.ncolumns)
+	{
+	  std::fprintf(b.file, "%g", r[0]);
+	  for (std::size_t j = i; j < i + b.ncolumns && j < b.nvalues; ++j)
+	    std::fprintf(b.file, " %g", r[1 + j]);
+	  std::fputc('\n', b.file);
+	}
+      
+      pthread_mutex_lock(&b.mutex);
+      
+      --b.count;
+      pthread_cond_signal(&b.not_full);
+    }
+  
+  pthread_mutex_unlock(&b.mutex);
+  
+  std::fflush(b.file);
+  return 0;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_PROBE_BUFFER_H
@@ -0,0 +1,557 @@
+#ifndef ANIMAL_SUPPORT_PROFILER_H
+#define ANIMAL_SUPPORT_PROFILER_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <time.h>
+#include <pthread.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Profiler class.
+/** Per-phase hot-path instrumentation.
+
+    Phases are named once (see ANIMAL_PROFILE_SCOPE) and timed
+    with scoped timers reading the time stamp counter (or the
+    monotonic clock when no TSC is available). Every thread
+    accumulates its own statistics, so timers never contend;
+    the threads are only merged when a report or a dump is
+    requested.
+    
+    The profiler is always compiled in and disabled by default:
+    a disabled timer costs one test. Call enable() (the move_*
+    programs do it when MOVE_PROFILE is set in the environment)
+    to start recording; statistics are then dumped at exit in
+    CSV, JSON and Chrome trace (chrome://tracing) formats.
+    
+    Declaration/Definition file: animal/support/profiler.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Profiler
+{
+
+public:
+
+  // Traits typedef
+  typedef unsigned long long Tick_t;
+  
+  enum { MAX_PHASES = 32,         ///< Max number of named phases
+	 MAX_EVENTS = 1 << 16 };  ///< Trace events kept per thread
+  
+  
+  /// Profiler instance shared by the whole program
+  static Profiler& instance();
+  
+  
+  /** @name Set */
+  //@{
+  /** Start recording; statistics are written at exit in
+      prefix.csv, prefix.json and prefix.trace.json */
+  void enable(const char* prefix);
+  
+  /// Stop recording (statistics are kept)
+  void disable();
+  
+  /// Register a phase name, return its id (same name, same id)
+  int phase(const char* name);
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True when timers record
+  bool enabled() const { return is_enabled; }
+  
+  /// Current tick value
+  static Tick_t ticks();
+  
+  /// Ticks to seconds conversion factor
+  double secondsPerTick() const;
+  //@}
+  
+  
+  /** @name Recording (use Scoped_Timer instead) */
+  //@{
+  void record(int id, Tick_t start, Tick_t stop);
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /** Print per-phase time spent since last report
+      (e.g. once per simulated second) */
+  void report(std::ostream& s);
+  
+  /// Write merged statistics in CSV format
+  void writeCSV(std::FILE* f) const;
+  
+  /// Write merged statistics in JSON format
+  void writeJSON(std::FILE* f) const;
+  
+  /// Write recorded events in Chrome trace format
+  void writeTrace(std::FILE* f) const;
+  
+  /// Write the three files using the prefix given to enable()
+  void dump() const;
+  //@}
+
+
+
+private:
+
+  struct Stat
+  {
+    unsigned long long count;
+    Tick_t total, min, max;
+    
+    Stat() : count(0), total(0), min(~Tick_t(0)), max(0)
+      {}
+    void add(Tick_t d)
+      {
+	++count; total += d;
+	if ( d < min ) min = d;
+	if ( d > max ) max = d;
+      }
+    void merge(const Stat& s)
+      {
+	count += s.count; total += s.total;
+	if ( s.min < min ) min = s.min;
+	if ( s.max > max ) max = s.max;
+      }
+  };
+  
+  struct Event
+  {
+    int id;
+    Tick_t start, duration;
+  };
+  
+  struct Thread_Data
+  {
+    int tid;
+    Stat stats[MAX_PHASES];
+    std::vector<Event> events;
+    unsigned long long dropped;
+    
+    Thread_Data(int n) : tid(n), dropped(0)
+      {
+	events.reserve(MAX_EVENTS);
+      }
+  };
+  
+  Profiler();
+  
+  // Data of the calling thread (created on first use)
+  Thread_Data& local();
+  
+  // Merge every thread statistics
+  void merge(Stat s[MAX_PHASES]) const;
+  
+  static void dumpAtExit();
+  
+  
+  volatile bool is_enabled;
+  char file_prefix[256];
+  
+  const char* names[MAX_PHASES];
+  int nphases;
+  
+  std::vector<Thread_Data*> threads;
+  mutable pthread_mutex_t lock;
+  
+  // Calibration points (TSC vs monotonic clock)
+  Tick_t tick0;
+  double ns0;
+  
+  // Totals at last report()
+  Tick_t reported[MAX_PHASES];
+  Tick_t report_tick;
+
+}; // class Profiler
+
+
+
+// ----------------------------------------------------------
+//
+//  Scoped_Timer class.
+/** Times the enclosing scope and records it in phase id.
+
+    Declaration/Definition file: animal/support/profiler.h
+    (creation date: October 19, 2026).
+    
+    @see Profiler */
+//
+// ----------------------------------------------------------
+
+class Scoped_Timer
+{
+
+public:
+
+  Scoped_Timer(int id)
+    : phase_id(id),
+      start( Profiler::instance().enabled() ? Profiler::ticks() : 0 )
+    {}
+  ~Scoped_Timer()
+    {
+      if ( start )
+	Profiler::instance().record(phase_id, start, Profiler::ticks());
+    }
+
+private:
+
+  int phase_id;
+  Profiler::Tick_t start;
+
+}; // class Scoped_Timer
+
+} } // namespace animal { namespace support {
+
+
+
+/** Time the enclosing scope (until its end) as phase name,
+    a string literal. The phase is registered once, on first
+    execution. */
+#define ANIMAL_PROFILE_SCOPE(name) \
+  ANIMAL_PROFILE_SCOPE_AT(name, __LINE__)
+  
+#define ANIMAL_PROFILE_SCOPE_AT(name, line) \
+  ANIMAL_PROFILE_SCOPE_AT_(name, line)
+  
+#define ANIMAL_PROFILE_SCOPE_AT_(name, line)                             \
+  static const int animal_profile_phase_##line =                         \
+    animal::support::Profiler::instance().phase(name);                   \
+  animal::support::Scoped_Timer                                          \
+    animal_profile_timer_##line(animal_profile_phase_##line)
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline double
+profiler_monotonic_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1.0e9 + ts.tv_nsec;
+}
+
+inline
+Profiler::
+Profiler()
+  : is_enabled(false), nphases(0),
+    tick0( ticks() ), ns0( profiler_monotonic_ns() ),
+    report_tick( tick0 )
+{
+  file_prefix[0] = '\0';
+  pthread_mutex_init(&lock, NULL);
+  
+  for (int i = 0; i < MAX_PHASES; ++i)
+    {
+      names[i] = "";
+      reported[i] = 0;
+    }
+}
+
+inline Profiler&
+Profiler::
+instance()
+{
+  static Profiler profiler; // Never deleted!
+  return profiler;
+}
+
+
+
+
+
+inline void
+Profiler::
+enable(const char* prefix)
+{
+  static bool registered = false;
+  
+  std::strncpy(file_prefix, prefix, sizeof(file_prefix) - 1);
+  file_prefix[sizeof(file_prefix) - 1] = '\0';
+  
+  if ( !registered )
+    {
+      std::atexit(dumpAtExit);
+      registered = true;
+    }
+  
+  is_enabled = true;
+}
+
+inline void
+Profiler::
+disable()
+{
+  is_enabled = false;
+}
+
+inline int
+Profiler::
+phase(const char* name)
+{
+  pthread_mutex_lock(&lock);
+  
+  int id;
+  for (id = 0; id < nphases; ++id)
+    if ( !std::strcmp(names[id], name) ) break;
+  
+  if ( id == nphases && nphases < MAX_PHASES )
+    names[nphases++] = name;
+  
+  if ( id == MAX_PHASES ) id = MAX_PHASES - 1; // Overflow: share last one
+  
+  pthread_mutex_unlock(&lock);
+  return id;
+}
+
+
+
+
+
+inline Profiler::Tick_t
+Profiler::
+ticks()
+{
+#if ( defined(__i386__) || defined(__x86_64__) ) && !defined(ANIMAL_PROFILER_NO_TSC)
+  unsigned int lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ( static_cast<Tick_t>(hi) << 32 ) | lo;
+#else
+  return static_cast<Tick_t>( profiler_monotonic_ns() );
+#endif
+}
+
+inline double
+Profiler::
+secondsPerTick() const
+{
+  Tick_t dt = ticks() - tick0;
+  double dns = profiler_monotonic_ns() - ns0;
+  
+  if ( dt == 0 || dns <= 0.0 ) return 1.0e-9;
+  return 1.0e-9 * dns/static_cast<double>(dt);
+}
+
+
+
+
+
+inline Profiler::Thread_Data&
+Profiler::
+local()
+{
+  static __thread Thread_Data* data = 0;
+  
+  if ( !data )
+    {
+      pthread_mutex_lock(&lock);
+      data = new Thread_Data( static_cast<int>( threads.size() ) ); // Never deleted!
+      threads.push_back(data);
+      pthread_mutex_unlock(&lock);
+    }
+  
+  return *data;
+}
+
+inline void
+Profiler::
+record(int id, Tick_t start, Tick_t stop)
+{
+  Thread_Data& data = local();
+  Tick_t d = stop - start;
+  
+  data.stats[id].add(d);
+  
+  if ( data.events.size() < MAX_EVENTS )
+    {
+      Event e;
+      e.id = id; e.start = start; e.duration = d;
+      data.events.push_back(e);
+    }
+  else
+    ++data.dropped;
+}
+
+inline void
+Profiler::
+merge(Stat s[MAX_PHASES]) const
+{
+  pthread_mutex_lock(&lock);
+  
+  for (unsigned int t = 0; t < threads.size(); ++t)
+    for (int i = 0; i < nphases; ++i)
+      s[i].merge(threads[t]->stats[i]);
+  
+  pthread_mutex_unlock(&lock);
+}
+
+
+
+
+
+inline void
+Profiler::
+report(std::ostream& s)
+{
+  Stat merged[MAX_PHASES];
+  merge(merged);
+  
+  double spt = secondsPerTick();
+  Tick_t now = ticks();
+  
+  s << "Elapsed time = " << (now - report_tick)*spt << " s";
+  for (int i = 0; i < nphases; ++i)
+    {
+      s << " | " << names[i] << " " << (merged[i].total - reported[i])*spt*1.0e3 << " ms";
+      reported[i] = merged[i].total;
+    }
+  s << std::endl;
+  
+  report_tick = now;
+}
+
+inline void
+Profiler::
+writeCSV(std::FILE* f) const
+{
+  Stat merged[MAX_PHASES];
+  merge(merged);
+  
+  double spt = secondsPerTick();
+  
+  std::fprintf(f, "phase,count,total_s,mean_us,min_us,max_us\n");
+  for (int i = 0; i < nphases; ++i)
+    {
+      const Stat& st = merged[i];
+      if ( st.count == 0 ) continue;
+      std::fprintf(f, "%s,%llu,%.9g,%.6g,%.6g,%.6g\n",
+		   names[i], st.count, st.total*spt,
+		   1.0e6*st.total*spt/st.count, 1.0e6*st.min*spt, 1.0e6*st.max*spt);
+    }
+}
+
+inline void
+Profiler::
+writeJSON(std::FILE* f) const
+{
+  Stat merged[MAX_PHASES];
+  merge(merged);
+  
+  double spt = secondsPerTick();
+  bool first = true;
+  
+  std::fprintf(f, "{\n  \"phases\": [\n");
+  for (int i = 0; i < nphases; ++i)
+    {
+      const Stat& st = merged[i];
+      if ( st.count == 0 ) continue;
+      std::fprintf(f, "%s    { \"name\": \"%s\", \"count\": %llu, \"total_s\": %.9g,"
+		   " \"mean_us\": %.6g, \"min_us\": %.6g, \"max_us\": %.6g }",
+		   first ? "" : ",\n",
+		   names[i], st.count, st.total*spt,
+		   1.0e6*st.total*spt/st.count, 1.0e6*st.min*spt, 1.0e6*st.max*spt);
+      first = false;
+    }
+  std::fprintf(f, "\n  ],\n  \"threads\": %u\n}\n",
+	       static_cast<unsigned int>( threads.size() ));
+}
+
+inline void
+Profiler::
+writeTrace(std::FILE* f) const
+{
+  double spt = secondsPerTick();
+  bool first = true;
+  
+  pthread_mutex_lock(&lock);
+  
+  std::fprintf(f, "{\"traceEvents\":[\n");
+  for (unsigned int t = 0; t < threads.size(); ++t)
+    {
+      const std::vector<Event>& ev = threads[t]->events;
+      
+      for (unsigned int e = 0; e < ev.size(); ++e)
+	{
+	  std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+		       "\"ts\":%.3f,\"dur\":%.3f}",
+		       first ? "" : ",\n",
+		       names[ev[e].id], threads[t]->tid,
+		       1.0e6*(ev[e].start - tick0)*spt, 1.0e6*ev[e].duration*spt);
+	  first = false;
+	}
+      
+      if ( threads[t]->dropped )
+	std::fprintf(stderr, "Profiler: thread %d dropped %llu trace events\n",
+		     threads[t]->tid, threads[t]->dropped);
+    }
+  std::fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  
+  pthread_mutex_unlock(&lock);
+}
+
+inline void
+Profiler::
+dump() const
+{
+  const char* suffix[3] = { ".csv", ".json", ".trace.json" };
+  char name[300];
+  
+  for (int i = 0; i < 3; ++i)
+    {
+      std::sprintf(name, "%s%s", file_prefix, suffix[i]);
+      
+      std::FILE* f = std::fopen(name, "w");
+      if ( !f )
+	{
+	  std::fprintf(stderr, "Profiler: cannot open output file %s\n", name);
+	  continue;
+	}
+      
+      if ( i == 0 ) writeCSV(f);
+      else if ( i == 1 ) writeJSON(f);
+      else writeTrace(f);
+      
+      std::fclose(f);
+    }
+}
+
+inline void
+Profiler::
+dumpAtExit()
+{
+  Profiler& p = instance();
+  if ( p.file_prefix[0] ) p.dump();
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_PROFILER_H
@@ -0,0 +1,132 @@
+#ifndef ANIMAL_SUPPORT_REDUCTION_H
+#define ANIMAL_SUPPORT_REDUCTION_H
+
+
+
+namespace animal { namespace support {
+
+/** Worker number of the calling thread (0 unless set by a
+    thread pool), used to pick reduction slots. */
+inline int& worker_id()
+{
+  static __thread int id = 0;
+  return id;
+}
+
+
+
+// ----------------------------------------------------------
+//
+//  Reduction class.
+/** Per-worker partial results, summed on demand.
+
+    Each worker accumulates into its own slot (see local()),
+    so that no synchronization is needed during the parallel
+    pass; slots are padded to a cache line so that workers do
+    not share lines either. The slots are summed, in worker
+    order, by sum().
+    
+    T must be default constructible and provide operator+=.
+    
+    Declaration/Definition file: animal/support/reduction.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+template <class T>
+
+class Reduction
+{
+
+public:
+
+  enum { MAX_WORKERS = 64, ///< Max number of slots
+	 LINE = 64 };      ///< Cache line size (in bytes)
+  
+  
+  /** @name Constructor */
+  //@{
+  Reduction()
+    {}
+  //@}
+  
+  
+  /** @name Accumulation */
+  //@{
+  /// Slot of the calling worker
+  T& local() { return slots[ worker_id() ].value; }
+  
+  /// Slot of worker w
+  T& slot(int w) { return slots[w].value; }
+  //@}
+  
+  
+  /** @name Reduction */
+  //@{
+  /// Reset every slot
+  void clear();
+  
+  /// Sum of the slots
+  T sum() const;
+  //@}
+
+
+
+private:
+
+  struct Slot
+  {
+    T value;
+    char pad[LINE - sizeof(T) % LINE];
+  } __attribute__ ((aligned (LINE)));
+  
+  Slot slots[MAX_WORKERS];
+
+}; // class Reduction
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+template <class T>
+inline void
+Reduction<T>::
+clear()
+{
+  for (int w = 0; w < MAX_WORKERS; ++w)
+    slots[w].value = T();
+}
+
+template <class T>
+inline T
+Reduction<T>::
+sum() const
+{
+  T s = slots[0].value;
+  
+  for (int w = 1; w < MAX_WORKERS; ++w)
+    s += slots[w].value;
+  
+  return s;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_REDUCTION_H
@@ -0,0 +1,257 @@
+#ifndef ANIMAL_SUPPORT_TASK_SCHEDULER_H
+#define ANIMAL_SUPPORT_TASK_SCHEDULER_H
+
+#include <cstddef>
+#include <vector>
+#include <animal/support/thread_pool.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Chunk_Task struct.
+/** Work on numbered chunks, run by a Task_Scheduler.
+
+    Declaration/Definition file: animal/support/task_scheduler.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+struct Chunk_Task
+{
+  /// Chunk c, run by worker w
+  virtual void operator()(std::size_t c, int w) = 0;
+
+  virtual ~Chunk_Task()
+    {}
+};
+
+
+
+// ----------------------------------------------------------
+//
+//  Task_Scheduler class.
+/** Work stealing over the workers of a Thread_Pool.
+
+    run() gives each worker a range of chunks, e.g. those of
+    the data placed on its node, in a deque: the worker takes
+    its chunks from the front, one at a time; once its deque
+    is empty, it steals half of the chunks left at the back of
+    another deque, the next workers first (those of the same
+    node), and goes on with them. The run ends when every
+    deque is empty, so that workers given costly chunks are
+    helped by the others.
+
+    A deque is a range of chunk numbers, head and tail packed
+    in one word: taking and stealing are single compare and
+    swap operations, without locks. Deques are padded to a
+    cache line.
+
+    With a single worker, chunks are run in order by the
+    calling thread.
+
+    Declaration/Definition file: animal/support/task_scheduler.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Task_Scheduler
+{
+
+public:
+
+  enum { LINE = 64 }; ///< Cache line size (in bytes)
+
+
+  /** @name Constructor */
+  //@{
+  /// Scheduler over the workers of p, which must outlive it
+  Task_Scheduler(Thread_Pool& p) : workers(p), nstolen(0)
+    {}
+  //@}
+
+
+  /** @name Get */
+  //@{
+  /// Workers
+  Thread_Pool& pool() { return workers; }
+
+  /// Number of workers
+  int size() const { return workers.size(); }
+
+  /// Steals during the last run()
+  std::size_t stolen() const { return nstolen; }
+  //@}
+
+
+  /** @name Run */
+  //@{
+  /** Run task on chunks [bounds[0], bounds[size()]), chunks
+      [bounds[w], bounds[w+1]) being first given to worker w */
+  void run(Chunk_Task& task, const std::vector<std::size_t>& bounds);
+
+  /// Run task on chunks [0, n), split evenly among the workers
+  void run(Chunk_Task& task, std::size_t n);
+  //@}
+
+
+
+private:
+
+  typedef unsigned long long Range; // tail << 32 | head
+
+  static Range pack(std::size_t head, std::size_t tail)
+    { return Range(tail) << 32 | Range(head); }
+  static std::size_t head(Range r) { return std::size_t(r & 0xffffffffULL); }
+  static std::size_t tail(Range r) { return std::size_t(r >> 32); }
+
+  struct Deque
+  {
+    volatile Range range;
+    volatile std::size_t steals;
+    char pad[LINE - sizeof(Range) - sizeof(std::size_t)];
+  } __attribute__ ((aligned (LINE)));
+
+  struct Steal_Task : public Thread_Task
+  {
+    Task_Scheduler* scheduler;
+    Chunk_Task* task;
+
+    void operator()(int w);
+  };
+
+  // Next chunk of worker w, from its deque or stolen; false when none is left
+  bool next(int w, std::size_t& c);
+
+
+  Thread_Pool& workers;
+  Deque deques[Reduction<int>::MAX_WORKERS];
+  std::size_t nstolen;
+
+}; // class Task_Scheduler
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline bool
+Task_Scheduler::
+next(int w, std::size_t& c)
+{
+  Deque& mine = deques[w];
+
+  // Front of the own deque
+  for (;;)
+    {
+      Range r = mine.range;
+      if ( head(r) >= tail(r) ) break;
+
+      if ( __sync_bool_compare_and_swap(&mine.range, r, pack(head(r) + 1, tail(r))) )
+	{
+	  c = head(r);
+	  return true;
+	}
+    }
+
+  // Back half of another one, the next workers first
+  const int n = workers.size();
+
+  for (int i = 1; i < n; ++i)
+    {
+      Deque& victim = deques[(w + i) % n];
+
+      for (;;)
+	{
+	  Range r = victim.range;
+	  std::size_t h = head(r), t = tail(r);
+	  if ( h >= t ) break;
+
+	  std::size_t first = t - (t - h + 1)/2;
+
+	  if ( __sync_bool_compare_and_swap(&victim.range, r, pack(h, first)) )
+	    {
+	      // Own deque is empty: only its owner fills it
+	      Range empty = mine.range;
+	      __sync_bool_compare_and_swap(&mine.range, empty, pack(first + 1, t));
+	      ++mine.steals;
+
+	      c = first;
+	      return true;
+	    }
+	}
+    }
+
+  return false;
+}
+
+inline void
+Task_Scheduler::
+Steal_Task::
+operator()(int w)
+{
+  std::size_t c;
+
+  while ( scheduler->next(w, c) )
+    (*task)(c, w);
+}
+
+inline void
+Task_Scheduler::
+run(Chunk_Task& task, const std::vector<std::size_t>& bounds)
+{
+  const int n = workers.size();
+
+  nstolen = 0;
+
+  if ( n == 1 )
+    {
+      for (std::size_t c = bounds[0]; c < bounds[1]; ++c)
+	task(c, 0);
+      return;
+    }
+
+  for (int w = 0; w < n; ++w)
+    {
+      deques[w].range = pack(bounds[w], bounds[w + 1]);
+      deques[w].steals = 0;
+    }
+
+  Steal_Task steal;
+  steal.scheduler = this;
+  steal.task = &task;
+
+  workers.run(steal);
+
+  for (int w = 0; w < n; ++w)
+    nstolen += deques[w].steals;
+}
+
+inline void
+Task_Scheduler::
+run(Chunk_Task& task, std::size_t n)
+{
+  run( task, workers.split(n) );
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_TASK_SCHEDULER_H
@@ -0,0 +1,10 @@
+#
+# async_writer.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= async_writer_test.C
+TARGET		= async_writer_test
@@ -0,0 +1,9 @@
+#
+# camera_script.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+SOURCES		= camera_script_test.C
+TARGET		= camera_script_test
@@ -0,0 +1,10 @@
+#
+# checkpoint.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= checkpoint_test.C
+TARGET		= checkpoint_test
@@ -0,0 +1,10 @@
+#
+# perf_counters.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= perf_counters_test.C
+TARGET		= perf_counters_test
@@ -0,0 +1,10 @@
+#
+# probe_buffer.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= probe_buffer_test.C
+TARGET		= probe_buffer_test
@@ -0,0 +1,10 @@
+#
+# profiler.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= profiler_test.C
+TARGET		= profiler_test
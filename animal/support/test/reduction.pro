@@ -0,0 +1,10 @@
+#
+# reduction.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= reduction_test.C
+TARGET		= reduction_test
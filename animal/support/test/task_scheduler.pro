@@ -0,0 +1,10 @@
+#
+# task_scheduler.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= task_scheduler_test.C
+TARGET		= task_scheduler_test
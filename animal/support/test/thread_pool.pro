@@ -0,0 +1,10 @@
+#
+# thread_pool.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= thread_pool_test.C
+TARGET		= thread_pool_test
@@ -0,0 +1,10 @@
+#
+# trajectory.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= trajectory_test.C
+TARGET		= trajectory_test
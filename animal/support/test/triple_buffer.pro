@@ -0,0 +1,10 @@
+#
+# triple_buffer.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on debug
+INCLUDEPATH	= ../../..
+LIBS		+= -lpthread
+SOURCES		= triple_buffer_test.C
+TARGET		= triple_buffer_test
@@ -0,0 +1,517 @@
+#ifndef ANIMAL_SUPPORT_THREAD_POOL_H
+#define ANIMAL_SUPPORT_THREAD_POOL_H
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <animal/support/reduction.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Thread_Task struct.
+/** Work run by every worker of a Thread_Pool, see
+    Thread_Pool::run().
+    
+    Declaration/Definition file: animal/support/thread_pool.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+struct Thread_Task
+{
+  /// Part of worker w, 0 <= w < Thread_Pool::size()
+  virtual void operator()(int w) = 0;
+  
+  virtual ~Thread_Task()
+    {}
+};
+
+
+
+// ----------------------------------------------------------
+//
+//  Thread_Pool class.
+/** Fixed set of workers, pinned to the processors allowed to
+    the process, running the same task on their own part of
+    the data (fork-join).
+    
+    Worker 0 is the thread calling start(), and then run(): it
+    takes its part of each task instead of waiting. The other
+    workers are threads of the pool, which set their
+    worker_id(), so that they accumulate into their own
+    Reduction slots.
+    
+    Processors are taken NUMA node by node (as listed in
+    /sys/devices/system/node), so that consecutive workers
+    share a node: consecutive parts of the data, given to
+    consecutive workers, stay on as few nodes as possible.
+    place() moves the pages of a vector to the nodes of the
+    workers that use them, relying on the first touch policy
+    of the kernel, without libnuma.
+    
+    Workers spin a little before sleeping, between tasks, so
+    that runs following each other closely (the passes of a
+    step) do not pay for a wake-up each; not when there are
+    more workers than processors.
+    
+    Declaration/Definition file: animal/support/thread_pool.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+class Thread_Pool
+{
+
+public:
+
+  enum { MAX_NODES = 64 }; ///< Nodes looked for by topology()
+  
+  
+  /** @name Constructors and destructor */
+  //@{
+  Thread_Pool();
+  
+  /// Stops the workers
+  ~Thread_Pool();
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /** Start n workers (0 for one per allowed processor, at most
+      Reduction<T>::MAX_WORKERS), the calling thread included;
+      with pin, worker w is bound to the w-th processor of
+      topology(). False (with a message) if no thread could be
+      created; the pool then has the calling thread only. */
+  bool start(int n, bool pin = true);
+  
+  /** Stop the workers, and unpin the thread that called start();
+      the pool then has this thread only */
+  void stop();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// Number of workers, the calling thread included
+  int size() const { return nworkers; }
+  
+  /// NUMA node of worker w (0 if unknown)
+  int node(int w) const { return w < int( nodes.size() ) ? nodes[w] : 0; }
+  
+  /// Number of NUMA nodes used by the workers
+  int nnodes() const;
+  
+  /** Bounds of n items split in size() consecutive ranges of
+      nearly equal sizes: range w is [bounds[w], bounds[w+1]) */
+  std::vector<std::size_t> split(std::size_t n) const;
+  
+  /** Processors allowed to the process, node by node, and the
+      node of each */
+  static void topology(std::vector<int>& cpus, std::vector<int>& nodes);
+  //@}
+  
+  
+  /** @name Run */
+  //@{
+  /// Run task on every worker, and return once all are done
+  void run(Thread_Task& task);
+  
+  /** Move the items of range w of v (see split()) to the node of
+      worker w: the whole pages of v are released, then filled
+      again by their workers. T must be copyable by assignment
+      onto zeroed memory (no owned resources) */
+  template <class T>
+  void place(std::vector<T>& v, const std::vector<std::size_t>& bounds);
+  //@}
+
+
+
+private:
+
+  // Not copyable
+  Thread_Pool(const Thread_Pool&);
+  Thread_Pool& operator=(const Thread_Pool&);
+  
+  struct Start
+  {
+    Thread_Pool* pool;
+    int worker;
+  };
+  
+  template <class T>
+  struct Place_Task : public Thread_Task
+  {
+    std::vector<T>* v;
+    const std::vector<T>* copy;
+    const std::vector<std::size_t>* bounds;
+    
+    void operator()(int w)
+      {
+	std::copy( copy->begin() + (*bounds)[w], copy->begin() + (*bounds)[w + 1],
+		   v->begin() + (*bounds)[w] );
+      }
+  };
+  
+  static void* loop(void* start);
+  
+  static bool pinTo(pthread_t thread, int cpu);
+  
+  
+  int nworkers;
+  std::vector<int> cpus;  // of each worker, -1 if not pinned
+  std::vector<int> nodes; // of each worker
+  
+  std::vector<pthread_t> threads; // threads[0] called start()
+  std::vector<Start> starts;
+  cpu_set_t affinity;             // of threads[0] before start()
+  
+  pthread_mutex_t mutex;
+  pthread_cond_t ready, done;
+  Thread_Task* volatile task;
+  volatile unsigned int generation; // of the current task
+  volatile int pending;             // workers still running it
+  volatile bool quit;
+  int spin; // polls before sleeping
+
+}; // class Thread_Pool
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+inline
+Thread_Pool::
+Thread_Pool()
+  : nworkers(1), cpus(1, -1), nodes(1, 0),
+    task(0), generation(0), pending(0), quit(false), spin(0)
+{
+  pthread_mutex_init(&mutex, 0);
+  pthread_cond_init(&ready, 0);
+  pthread_cond_init(&done, 0);
+}
+
+inline
+Thread_Pool::
+~Thread_Pool()
+{
+  stop();
+  
+  pthread_cond_destroy(&done);
+  pthread_cond_destroy(&ready);
+  pthread_mutex_destroy(&mutex);
+}
+
+inline void
+Thread_Pool::
+topology(std::vector<int>& cpus, std::vector<int>& nodes)
+{
+  cpus.clear();
+  nodes.clear();
+  
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if ( sched_getaffinity(0, sizeof(allowed), &allowed) )
+    {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      for (long c = 0; c < n && c < CPU_SETSIZE; ++c)
+	CPU_SET(c, &allowed);
+    }
+  
+  // "0-3,8-11" lists of the nodes (numbers may have gaps)
+  for (int node = 0; node < MAX_NODES; ++node)
+    {
+      char name[64];
+      std::sprintf(name, "/sys/devices/system/node/node%d/cpulist", node);
+      
+      std::FILE* file = std::fopen(name, "r");
+      if ( !file ) continue;
+      
+      int first, last;
+      while ( std::fscanf(file, "%d", &first) == 1 )
+	{
+	  last = first;
+	  int c = std::fgetc(file);
+	  if ( c == '-' )
+	    {
+	      if ( std::fscanf(file, "%d", &last) != 1 ) break;
+	      c = std::fgetc(file);
+	    }
+	  
+	  for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+	    if ( CPU_ISSET(cpu, &allowed) )
+	      {
+		cpus.push_back(cpu);
+		nodes.push_back(node);
+		CPU_CLR(cpu, &allowed);
+	      }
+	  
+	  if ( c != ',' ) break;
+	}
+      
+      std::fclose(file);
+    }
+  
+  // Processors of no node listed (no /sys): node 0
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if ( CPU_ISSET(cpu, &allowed) )
+      {
+	cpus.push_back(cpu);
+	nodes.push_back(0);
+      }
+}
+
+inline bool
+Thread_Pool::
+pinTo(pthread_t thread, int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  
+  return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+inline bool
+Thread_Pool::
+start(int n, bool pin)
+{
+  stop();
+  
+  std::vector<int> all_cpus, all_nodes;
+  topology(all_cpus, all_nodes);
+  
+  if ( n <= 0 ) n = all_cpus.empty() ? 1 : all_cpus.size();
+  if ( n > Reduction<int>::MAX_WORKERS ) n = Reduction<int>::MAX_WORKERS;
+  
+  cpus.assign(n, -1);
+  nodes.assign(n, 0);
+  spin = n <= int( all_cpus.size() ) ? 2000 : 0;
+  
+  // Round robin over the processors if there are more workers
+  if ( pin && !all_cpus.empty() )
+    for (int w = 0; w < n; ++w)
+      {
+	cpus[w] = all_cpus[ w % all_cpus.size() ];
+	nodes[w] = all_nodes[ w % all_cpus.size() ];
+      }
+  
+  quit = false;
+  pending = 0;
+  threads.resize(n);
+  starts.resize(n);
+  nworkers = 1;
+  
+  threads[0] = pthread_self();
+  pthread_getaffinity_np(threads[0], sizeof(affinity), &affinity);
+  if ( cpus[0] >= 0 ) pinTo(threads[0], cpus[0]);
+  worker_id() = 0;
+  
+  for (int w = 1; w < n; ++w)
+    {
+      starts[w].pool = this;
+      starts[w].worker = w;
+      
+      if ( pthread_create(&threads[w], 0, loop, &starts[w]) )
+	{
+	  std::perror("Thread_Pool: thread");
+	  stop();
+	  return false;
+	}
+      
+      if ( cpus[w] >= 0 ) pinTo(threads[w], cpus[w]);
+      ++nworkers;
+    }
+  
+  return true;
+}
+
+inline void
+Thread_Pool::
+stop()
+{
+  pthread_mutex_lock(&mutex);
+  quit = true;
+  pthread_cond_broadcast(&ready);
+  pthread_mutex_unlock(&mutex);
+  
+  for (int w = 1; w < nworkers; ++w)
+    pthread_join(threads[w], 0);
+  
+  if ( !threads.empty() && cpus[0] >= 0 )
+    pthread_setaffinity_np(threads[0], sizeof(affinity), &affinity);
+  
+  nworkers = 1;
+  cpus.assign(1, -1);
+  nodes.assign(1, 0);
+  threads.clear();
+  starts.clear();
+}
+
+
+
+
+
+inline int
+Thread_Pool::
+nnodes() const
+{
+  std::vector<int> n(nodes);
+  std::sort(n.begin(), n.end());
+  
+  return std::unique(n.begin(), n.end()) - n.begin();
+}
+
+inline std::vector<std::size_t>
+Thread_Pool::
+split(std::size_t n) const
+{
+  std::vector<std::size_t> bounds(nworkers + 1);
+  
+  for (int w = 0; w <= nworkers; ++w)
+    bounds[w] = n*w/nworkers;
+  
+  return bounds;
+}
+
+
+
+
+
+inline void*
+Thread_Pool::
+loop(void* start)
+{
+  Thread_Pool& p = *static_cast<Start*>(start)->pool;
+  const int w = static_cast<Start*>(start)->worker;
+  
+  worker_id() = w;
+  
+  unsigned int seen = 0;
+  
+  for (;;)
+    {
+      // Poll a while for the next task (some microseconds)
+      for (int i = 0; i < p.spin && p.generation == seen && !p.quit; ++i)
+	__sync_synchronize();
+      
+      pthread_mutex_lock(&p.mutex);
+      
+      while ( p.generation == seen && !p.quit )
+	pthread_cond_wait(&p.ready, &p.mutex);
+      
+      if ( p.quit )
+	{
+	  pthread_mutex_unlock(&p.mutex);
+	  break;
+	}
+      
+      seen = p.generation;
+      Thread_Task* task = p.task;
+      
+      pthread_mutex_unlock(&p.mutex);
+      
+      (*task)(w);
+      
+      if ( __sync_sub_and_fetch(&p.pending, 1) == 0 )
+	{
+	  pthread_mutex_lock(&p.mutex);
+	  pthread_cond_signal(&p.done);
+	  pthread_mutex_unlock(&p.mutex);
+	}
+    }
+  
+  return 0;
+}
+
+inline void
+Thread_Pool::
+run(Thread_Task& t)
+{
+  if ( nworkers == 1 )
+    {
+      t(0);
+      return;
+    }
+  
+  pthread_mutex_lock(&mutex);
+  task = &t;
+  pending = nworkers - 1;
+  ++generation;
+  pthread_cond_broadcast(&ready);
+  pthread_mutex_unlock(&mutex);
+  
+  t(0);
+  
+  for (int i = 0; i < spin && pending > 0; ++i)
+    __sync_synchronize();
+  
+  if ( pending > 0 )
+    {
+      pthread_mutex_lock(&mutex);
+      while ( pending > 0 )
+	pthread_cond_wait(&done, &mutex);
+      pthread_mutex_unlock(&mutex);
+    }
+  
+  __sync_synchronize(); // results of the workers visible
+}
+
+template <class T>
+inline void
+Thread_Pool::
+place(std::vector<T>& v, const std::vector<std::size_t>& bounds)
+{
+  if ( nworkers == 1 || v.empty() ) return;
+  
+  const std::vector<T> copy(v);
+  
+  const std::size_t page = sysconf(_SC_PAGESIZE);
+  char* first = reinterpret_cast<char*>( &v[0] );
+  char* last = first + v.size()*sizeof(T);
+  char* first_page = reinterpret_cast<char*>
+    ( (reinterpret_cast<std::size_t>(first) + page - 1)/page*page );
+  char* last_page = reinterpret_cast<char*>
+    ( reinterpret_cast<std::size_t>(last)/page*page );
+  
+  // Zero pages, allocated again on the node of the first writer
+  if ( first_page < last_page )
+    madvise(first_page, last_page - first_page, MADV_DONTNEED);
+  
+  Place_Task<T> fill;
+  fill.v = &v;
+  fill.copy = &copy;
+  fill.bounds = &bounds;
+  
+  run(fill);
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_THREAD_POOL_H
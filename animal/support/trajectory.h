@@ -0,0 +1,695 @@
+#ifndef ANIMAL_SUPPORT_TRAJECTORY_H
+#define ANIMAL_SUPPORT_TRAJECTORY_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+/** @name Trajectory file format
+
+    A trajectory is a sequence of frames, each one holding, at
+    a given date, ncomponents values (e.g. position and velocity
+    coordinates) for each of n items (e.g. particles).
+    
+    Each component c is quantized: a value v is stored as the
+    integer round(v / quantum[c]), so that it is read back
+    within quantum[c]/2. Integers are stored as differences:
+    with the same item in the previous frame, or, in the first
+    frame of a chunk, with the previous item. Differences are
+    small for smooth motions and nearby items; they are written
+    as variable length integers (7 bits per byte, zigzag for the
+    sign), usually one or two bytes per value.
+    
+    The file is a header (magic, byte order, version, n,
+    ncomponents, quanta) followed by chunks of consecutive
+    frames. A chunk can be decoded on its own, and starts with
+    its number of frames, the index of its first frame and its
+    size, so that a reader can skip it.
+    
+    Declaration/Definition file: animal/support/trajectory.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+//@{
+
+struct Trajectory_Header
+{
+  char magic[8];        // "ANIMTRAJ"
+  uint32_t order;       // 0x01020304, as written
+  uint32_t version;     // of the format
+  uint64_t n;           // items per frame
+  uint32_t ncomponents; // values per item
+  uint32_t reserved;
+  // followed by ncomponents quanta (double)
+};
+
+struct Trajectory_Chunk
+{
+  char magic[4];        // "TCHK"
+  uint32_t nframes;
+  uint64_t first;       // index of the first frame
+  uint64_t size;        // of the encoded values, in bytes
+  // followed by nframes dates (double), then the encoded values
+};
+
+//@}
+
+
+
+// ----------------------------------------------------------
+//
+//  Trajectory_Writer class.
+/** Writer of compressed trajectories, in the background.
+
+    frame() gives a buffer to fill with the values of a frame
+    (item after item, component after component), push() queues
+    it; a background thread encodes the queued frames and writes
+    the chunks. At most max_pending frames are waiting: frame()
+    blocks when the writer thread is that late.
+    
+    Declaration/Definition file: animal/support/trajectory.h
+    (creation date: October 19, 2026).
+    
+    @see Trajectory_Reader */
+//
+// ----------------------------------------------------------
+
+class Trajectory_Writer
+{
+
+public:
+
+  /// Current version of the format
+  static uint32_t version() { return 1; }
+  
+  
+  /** @name Constructors and destructor */
+  //@{
+  Trajectory_Writer(std::size_t max_pending = 8, uint32_t chunk_frames = 32);
+  
+  /// Writes the last chunk and closes the file
+  ~Trajectory_Writer();
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /** Open name for frames of n items of ncomponents values,
+      quantized by quantum[0 .. ncomponents-1] (positive), and
+      start the writer thread; false on error */
+  bool open(const char* name, std::size_t n, uint32_t ncomponents, const double quantum[]);
+  
+  /// Encode and write the queued frames, stop the writer thread and close the file
+  void close();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// True between open() and close()
+  bool isOpen() const { return is_open; }
+  
+  /// Number of frames pushed
+  uint64_t frames() const { return nframes; }
+  //@}
+  
+  
+  /** @name Output */
+  //@{
+  /// Buffer of the next frame, n*ncomponents values to be set
+  double* frame(double date);
+  
+  /// Queue the frame returned by the last frame() call
+  void push();
+  //@}
+
+
+
+private:
+
+  struct Frame
+  {
+    double date;
+    std::vector<double> values;
+  };
+  
+  // Not copyable
+  Trajectory_Writer(const Trajectory_Writer&);
+  Trajectory_Writer& operator=(const Trajectory_Writer&);
+  
+  static void* run(void* writer);
+  
+  // Writer thread
+  void encode(const Frame& f);
+  void writeChunk();
+  
+  
+  std::FILE* file;
+  bool is_open;
+  
+  uint64_t nitems;
+  uint32_t ncomp;
+  std::vector<double> quanta;
+  
+  std::size_t max_queue; // of pending frames
+  uint32_t chunk_size;   // frames per chunk
+  uint64_t nframes;      // pushed
+  
+  Frame* current;
+  std::deque<Frame*> pending;
+  std::vector<Frame*> spare;
+  bool stop;
+  
+  // Chunk being encoded (writer thread only)
+  std::vector<int64_t> last; // quantized values of the previous frame
+  std::vector<double> dates;
+  std::vector<unsigned char> bytes;
+  uint64_t first;
+  
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t not_empty, not_full;
+
+}; // class Trajectory_Writer
+
+
+
+// ----------------------------------------------------------
+//
+//  Trajectory_Reader class.
+/** Reader of compressed trajectories.
+
+    Frames are decoded in order by next(); seek() goes to a
+    given frame, skipping the chunks before it.
+    
+    Declaration/Definition file: animal/support/trajectory.h
+    (creation date: October 19, 2026).
+    
+    @see Trajectory_Writer */
+//
+// ----------------------------------------------------------
+
+class Trajectory_Reader
+{
+
+public:
+
+  /** @name Constructor and destructor */
+  //@{
+  Trajectory_Reader() : file(0), nitems(0), ncomp(0), frame_index(0), chunk_frames(0), chunk_next(0)
+    {}
+  ~Trajectory_Reader() { close(); }
+  //@}
+  
+  
+  /** @name Set */
+  //@{
+  /// Open name and read its header, false (with a message) on error
+  bool open(const char* name);
+  
+  void close();
+  //@}
+  
+  
+  /** @name Get */
+  //@{
+  /// Items per frame
+  std::size_t items() const { return nitems; }
+  
+  /// Values per item
+  uint32_t components() const { return ncomp; }
+  
+  /// Quantum of component c
+  double quantum(uint32_t c) const { return quanta[c]; }
+  
+  /// Index of the frame next() reads
+  uint64_t index() const { return frame_index; }
+  //@}
+  
+  
+  /** @name Input */
+  //@{
+  /// Decode the next frame, false at the end of the file (or on error)
+  bool next(double& date, std::vector<double>& values);
+  
+  /// Go to frame i, false if there are fewer frames
+  bool seek(uint64_t i);
+  //@}
+
+
+
+private:
+
+  bool readChunk();
+  
+  bool failed(const char* name, const char* what)
+    {
+      std::fprintf(stderr, "Trajectory %s: %s\n", name, what);
+      close();
+      return false;
+    }
+  
+  // Not copyable
+  Trajectory_Reader(const Trajectory_Reader&);
+  Trajectory_Reader& operator=(const Trajectory_Reader&);
+  
+  
+  std::FILE* file;
+  long data; // offset of the first chunk
+  
+  std::size_t nitems;
+  uint32_t ncomp;
+  std::vector<double> quanta;
+  
+  uint64_t frame_index;
+  
+  // Chunk being decoded
+  std::vector<double> dates;
+  std::vector<unsigned char> bytes;
+  std::size_t position;        // in bytes
+  std::vector<int64_t> last;   // quantized values of the previous frame
+  uint64_t chunk_first;
+  uint32_t chunk_frames;
+  uint32_t chunk_next;         // index in the chunk of the next frame
+
+}; // class Trajectory_Reader
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+// Variable length integers: 7 bits per byte, low bits first,
+// high bit set on all bytes but the last; zigzag sign (0, -1,
+// 1, -2... are 0, 1, 2, 3...)
+
+inline void
+put_varint(std::vector<unsigned char>& bytes, int64_t i)
+{
+  uint64_t u = ( static_cast<uint64_t>(i) << 1 ) ^ static_cast<uint64_t>(i >> 63);
+  
+  while ( u >= 0x80 )
+    {
+      bytes.push_back( static_cast<unsigned char>(u | 0x80) );
+      u >>= 7;
+    }
+  bytes.push_back( static_cast<unsigned char>(u) );
+}
+
+inline bool
+get_varint(const std::vector<unsigned char>& bytes, std::size_t& position, int64_t& i)
+{
+  uint64_t u = 0;
+  
+  for (int shift = 0; shift < 64; shift += 7)
+    {
+      if ( position >= bytes.size() ) return false;
+      
+      unsigned char b = bytes[position++];
+      u |= static_cast<uint64_t>(b & 0x7f) << shift;
+      
+      if ( !(b & 0x80) )
+	{
+	  i = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+	  return true;
+	}
+    }
+  
+  return false;
+}
+
+
+
+
+
+inline
+Trajectory_Writer::
+Trajectory_Writer(std::size_t max_pending, uint32_t chunk_frames)
+  : file(0), is_open(false),
+    nitems(0), ncomp(0),
+    max_queue(max_pending), chunk_size(chunk_frames), nframes(0),
+    current(0), stop(false), first(0)
+{
+  pthread_mutex_init(&mutex, 0);
+  pthread_cond_init(&not_empty, 0);
+  pthread_cond_init(&not_full, 0);
+}
+
+inline
+Trajectory_Writer::
+~Trajectory_Writer()
+{
+  close();
+  
+  for (std::size_t i = 0; i < spare.size(); ++i)
+    delete spare[i];
+  
+  pthread_cond_destroy(&not_full);
+  pthread_cond_destroy(&not_empty);
+  pthread_mutex_destroy(&mutex);
+}
+
+inline bool
+Trajectory_Writer::
+open(const char* name, std::size_t n, uint32_t ncomponents, const double quantum[])
+{
+  close();
+  
+  file = std::fopen(name, "wb");
+  if ( !file ) return false;
+  
+  nitems = n;
+  ncomp = ncomponents;
+  quanta.assign(quantum, quantum + ncomponents);
+  nframes = 0;
+  
+  Trajectory_Header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "ANIMTRAJ", 8);
+  h.order = 0x01020304;
+  h.version = version();
+  h.n = nitems;
+  h.ncomponents = ncomp;
+  
+  std::fwrite(&h, sizeof(h), 1, file);
+  std::fwrite(&quanta[0], sizeof(double), ncomp, file);
+  
+  // Frame buffers, reused
+  for (std::size_t i = spare.size(); i < max_queue + 1; ++i)
+    spare.push_back(new Frame);
+  
+  for (std::size_t i = 0; i < spare.size(); ++i)
+    spare[i]->values.resize(nitems*ncomp);
+  
+  last.assign(nitems*ncomp, 0);
+  dates.clear();
+  bytes.clear();
+  first = 0;
+  
+  stop = false;
+  if ( pthread_create(&thread, 0, run, this) )
+    {
+      std::fclose(file);
+      file = 0;
+      return false;
+    }
+  
+  is_open = true;
+  return true;
+}
+
+inline void
+Trajectory_Writer::
+close()
+{
+  if ( !is_open ) return;
+  
+  pthread_mutex_lock(&mutex);
+  stop = true;
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+  
+  pthread_join(thread, 0);
+  
+  std::fclose(file);
+  file = 0;
+  is_open = false;
+}
+
+
+
+
+
+inline double*
+Trajectory_Writer::
+frame(double date)
+{
+  pthread_mutex_lock(&mutex);
+  
+  while ( spare.empty() )
+    pthread_cond_wait(&not_full, &mutex);
+  
+  current = spare.back();
+  spare.pop_back();
+  
+  pthread_mutex_unlock(&mutex);
+  
+  current->date = date;
+  return &current->values[0];
+}
+
+inline void
+Trajectory_Writer::
+push()
+{
+  pthread_mutex_lock(&mutex);
+  
+  pending.push_back(current);
+  current = 0;
+  ++nframes;
+  
+  pthread_cond_signal(&not_empty);
+  pthread_mutex_unlock(&mutex);
+}
+
+inline void*
+Trajectory_Writer::
+run(void* writer)
+{
+  Trajectory_Writer& w = *static_cast<Trajectory_Writer*>(writer);
+  
+  pthread_mutex_lock(&w.mutex);
+  
+  for (;;)
+    {
+      while ( w.pending.empty() && !w.stop )
+	pthread_cond_wait(&w.not_empty, &w.mutex);
+      
+      if ( w.pending.empty() ) break; // stopped, and everything encoded
+      
+      Frame* f = w.pending.front();
+      w.pending.pop_front();
+      
+      // Encode and write outside the lock
+      pthread_mutex_unlock(&w.mutex);
+      w.encode(*f);
+      if ( w.dates.size() == w.chunk_size ) w.writeChunk();
+      pthread_mutex_lock(&w.mutex);
+      
+      w.spare.push_back(f);
+      pthread_cond_signal(&w.not_full);
+    }
+  
+  pthread_mutex_unlock(&w.mutex);
+  
+  w.writeChunk();
+  std::fflush(w.file);
+  return 0;
+}
+
+inline void
+Trajectory_Writer::
+encode(const Frame& f)
+{
+  const bool key = dates.empty(); // first frame of the chunk
+  dates.push_back(f.date);
+  
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < nitems; ++i)
+    for (uint32_t c = 0; c < ncomp; ++c, ++k)
+      {
+	int64_t q = static_cast<int64_t>( std::floor(f.values[k]/quanta[c] + 0.5) );
+	int64_t previous = key ? ( i > 0 ? last[k - ncomp] : 0 ) : last[k];
+	
+	put_varint(bytes, q - previous);
+	last[k] = q;
+      }
+}
+
+inline void
+Trajectory_Writer::
+writeChunk()
+{
+  if ( dates.empty() ) return;
+  
+  Trajectory_Chunk h;
+  std::memcpy(h.magic, "TCHK", 4);
+  h.nframes = dates.size();
+  h.first = first;
+  h.size = bytes.size();
+  
+  std::fwrite(&h, sizeof(h), 1, file);
+  std::fwrite(&dates[0], sizeof(double), dates.size(), file);
+  std::fwrite(&bytes[0], 1, bytes.size(), file);
+  
+  first += dates.size();
+  dates.clear();
+  bytes.clear();
+}
+
+
+
+
+
+inline bool
+Trajectory_Reader::
+open(const char* name)
+{
+  close();
+  
+  file = std::fopen(name, "rb");
+  if ( !file ) return failed(name, "cannot open file");
+  
+  Trajectory_Header h;
+  if ( std::fread(&h, sizeof(h), 1, file) != 1 ||
+       std::memcmp(h.magic, "ANIMTRAJ", 8) )
+    return failed(name, "not a trajectory");
+  if ( h.order != 0x01020304 ) return failed(name, "other byte order");
+  if ( h.version != Trajectory_Writer::version() ) return failed(name, "other format version");
+  
+  nitems = h.n;
+  ncomp = h.ncomponents;
+  quanta.resize(ncomp);
+  
+  if ( std::fread(&quanta[0], sizeof(double), ncomp, file) != ncomp )
+    return failed(name, "truncated file");
+  
+  data = std::ftell(file);
+  last.assign(nitems*ncomp, 0);
+  frame_index = 0;
+  chunk_frames = chunk_next = 0;
+  
+  return true;
+}
+
+inline void
+Trajectory_Reader::
+close()
+{
+  if ( !file ) return;
+  
+  std::fclose(file);
+  file = 0;
+}
+
+inline bool
+Trajectory_Reader::
+readChunk()
+{
+  Trajectory_Chunk h;
+  
+  if ( std::fread(&h, sizeof(h), 1, file) != 1 ||
+       std::memcmp(h.magic, "TCHK", 4) )
+    return false;
+  
+  dates.resize(h.nframes);
+  bytes.resize(h.size);
+  
+  if ( std::fread(&dates[0], sizeof(double), h.nframes, file) != h.nframes ||
+       std::fread(&bytes[0], 1, h.size, file) != h.size )
+    return false;
+  
+  position = 0;
+  chunk_first = h.first;
+  chunk_frames = h.nframes;
+  chunk_next = 0;
+  
+  return true;
+}
+
+inline bool
+Trajectory_Reader::
+next(double& date, std::vector<double>& values)
+{
+  if ( !file ) return false;
+  if ( chunk_next == chunk_frames && !readChunk() ) return false;
+  
+  const bool key = ( chunk_next == 0 );
+  date = dates[chunk_next++];
+  values.resize(nitems*ncomp);
+  
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < nitems; ++i)
+    for (uint32_t c = 0; c < ncomp; ++c, ++k)
+      {
+	int64_t d;
+	if ( !get_varint(bytes, position, d) ) return false;
+	
+	last[k] = d + ( key ? ( i > 0 ? last[k - ncomp] : 0 ) : last[k] );
+	values[k] = last[k]*quanta[c];
+      }
+  
+  ++frame_index;
+  return true;
+}
+
+inline bool
+Trajectory_Reader::
+seek(uint64_t i)
+{
+  if ( !file ) return false;
+  
+  // Back to the first chunk, then skip whole chunks
+  std::fseek(file, data, SEEK_SET);
+  chunk_frames = chunk_next = 0;
+  frame_index = 0;
+  
+  for (;;)
+    {
+      long start = std::ftell(file);
+      Trajectory_Chunk h;
+      
+      if ( std::fread(&h, sizeof(h), 1, file) != 1 ||
+	   std::memcmp(h.magic, "TCHK", 4) )
+	return false;
+      
+      if ( i < h.first + h.nframes )
+	{
+	  std::fseek(file, start, SEEK_SET);
+	  break;
+	}
+      
+      std::fseek(file, h.nframes*sizeof(double) + h.size, SEEK_CUR);
+    }
+  
+  if ( !readChunk() ) return false;
+  frame_index = chunk_first;
+  
+  // Decode the frames before i in the chunk
+  double date;
+  std::vector<double> values;
+  while ( frame_index < i )
+    if ( !next(date, values) ) return false;
+  
+  return true;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_TRAJECTORY_H
@@ -0,0 +1,135 @@
+#ifndef ANIMAL_SUPPORT_TRIPLE_BUFFER_H
+#define ANIMAL_SUPPORT_TRIPLE_BUFFER_H
+
+
+
+namespace animal { namespace support {
+
+// ----------------------------------------------------------
+//
+//  Triple_Buffer class.
+/** Lock-free hand-off of the latest value from one producer
+    thread to one consumer thread.
+    
+    The producer fills writeBuffer() then calls publish(); the
+    consumer calls update() then reads readBuffer(). The two
+    threads never wait for each other: the third buffer always
+    holds the latest published value, which update() exchanges
+    with the read buffer when it is newer. Intermediate values
+    are dropped if the consumer is slower than the producer.
+    
+    Buffers are exchanged, never copied, so T may hold large
+    vectors.
+    
+    Declaration/Definition file: animal/support/triple_buffer.h
+    (creation date: October 19, 2026). */
+//
+// ----------------------------------------------------------
+
+template <class T>
+
+class Triple_Buffer
+{
+
+public:
+
+  /** @name Constructor */
+  //@{
+  Triple_Buffer()
+    : write_index(0), middle(1), read_index(2)
+    {}
+  //@}
+  
+  
+  /** @name Producer side */
+  //@{
+  /// Buffer to fill before publish()
+  T& writeBuffer() { return buffers[write_index]; }
+  
+  /// Make the write buffer the latest value
+  void publish();
+  //@}
+  
+  
+  /** @name Consumer side */
+  //@{
+  /// Take the latest value if there is a new one; true if so
+  bool update();
+  
+  /// Latest value taken by update()
+  const T& readBuffer() const { return buffers[read_index]; }
+  
+  /// True if a value was published since the last update()
+  bool isFresh() const { return middle & FRESH; }
+  //@}
+
+
+
+private:
+
+  enum { INDEX = 3, FRESH = 4 };
+  
+  T buffers[3];
+  
+  int write_index;     // producer only
+  volatile int middle; // shared: index, and FRESH bit
+  int read_index;      // consumer only
+
+}; // class Triple_Buffer
+
+} } // namespace animal { namespace support {
+
+
+
+
+
+
+
+
+
+
+// -------------------------------------------------------------
+//
+//   D E F I N I T I O N   O F   I N L I N E D   M E T H O D S
+//
+// -------------------------------------------------------------
+
+namespace animal { namespace support {
+
+template <class T>
+inline void
+Triple_Buffer<T>::
+publish()
+{
+  int old;
+  
+  // Full barrier: the buffer content is visible before the index
+  do
+    old = middle;
+  while ( !__sync_bool_compare_and_swap(&middle, old, write_index | FRESH) );
+  
+  write_index = old & INDEX;
+}
+
+template <class T>
+inline bool
+Triple_Buffer<T>::
+update()
+{
+  if ( !(middle & FRESH) ) return false;
+  
+  int old;
+  
+  do
+    old = middle;
+  while ( !__sync_bool_compare_and_swap(&middle, old, read_index) );
+  
+  read_index = old & INDEX;
+  return true;
+}
+
+} } // namespace animal { namespace support {
+
+
+
+#endif // ANIMAL_SUPPORT_TRIPLE_BUFFER_H
@@ -0,0 +1,252 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <time.h>
+#include "../scheme.h"
+
+// ----------------------------------------------------------
+//
+//  bench.h
+//  Helpers of the benchmarks: compiled variant, clock, and
+//  synthetic cubeMaker-style meshes.
+//
+//  File: bench/bench.h
+//  (creation date: October 19, 2026).
+//
+// ----------------------------------------------------------
+
+typedef std::vector<Spring>         spring_v;
+typedef std::vector<TetraSpring>    tetraspring_v;
+typedef std::vector<HexaSpring>     hexaspring_v;
+typedef std::vector<Particle_State> ps_v;
+typedef std::vector<Particle_Model> pm_v;
+
+/// Compiled variant, e.g. "ALTERN+DAMPED", "MIXED+CONSTVOL" or "none"
+inline const char* variant()
+{
+  static char name[32] = "";
+  
+  if ( !name[0] )
+    {
+#if SINGLE
+      strcat(name, "+SINGLE");
+#elif MIXED
+      strcat(name, "+MIXED");
+#endif
+#if ALTERN
+      strcat(name, "+ALTERN");
+#endif
+#if DAMPED
+      strcat(name, "+DAMPED");
+#endif
+#if CONSTVOL
+      strcat(name, "+CONSTVOL");
+#endif
+      if ( !name[0] ) strcpy(name, "+none");
+    }
+  
+  return name + 1;
+}
+
+inline double now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.0e-09*ts.tv_nsec;
+}
+
+/// Deterministic jitter in [-a, a]
+inline Real jitter(unsigned int& seed, Real a)
+{
+  seed = seed*1103515245u + 12345u;
+  return a*( 2.0*((seed >> 8) & 0xffff)/65535.0 - 1.0 );
+}
+
+
+
+
+
+/* Synthetic meshes */
+
+/** Grid of (n+1)^3 particles with unit spacing, slightly
+    perturbed and moving, numbered as in cubeMaker */
+inline void makeParticles(int n, ps_v& state, pm_v& model)
+{
+  int v = n + 1;
+  unsigned int seed = 1;
+  
+  state.resize(v*v*v);
+  model.resize(v*v*v);
+  
+  for (int l = 0; l < v; l++)
+    for (int h = 0; h < v; h++)
+      for (int w = 0; w < v; w++)
+	{
+	  Particle_State& s = state[w + h*v + l*v*v];
+	  s.pos = Vec3(w + jitter(seed, 0.05), h + jitter(seed, 0.05), l + jitter(seed, 0.05));
+	  s.vel = Vec3(jitter(seed, 0.1), jitter(seed, 0.1), jitter(seed, 0.1));
+	  s.constraint = Particle_State::NO_CONSTRAINT;
+	  
+	  model[w + h*v + l*v*v].m = 1.0;
+	  model[w + h*v + l*v*v].f = Vec3_Acc::null();
+	}
+}
+
+/// Vertices of cube (w, h, l) in cubeMaker order
+inline void cubeVertices(int n, int w, int h, int l, int c[8])
+{
+  int v = n + 1;
+  
+  c[0] =  w    +  h   *v +  l   *v*v;
+  c[1] = (w+1) +  h   *v +  l   *v*v;
+  c[2] = (w+1) + (h+1)*v +  l   *v*v;
+  c[3] =  w    + (h+1)*v +  l   *v*v;
+  c[4] =  w    +  h   *v + (l+1)*v*v;
+  c[5] = (w+1) +  h   *v + (l+1)*v*v;
+  c[6] = (w+1) + (h+1)*v + (l+1)*v*v;
+  c[7] =  w    + (h+1)*v + (l+1)*v*v;
+}
+
+/// Springs along the 3*n*(n+1)^2 grid edges
+inline void makeSprings(int n, const ps_v& state, spring_v& springs)
+{
+  int v = n + 1;
+  
+  springs.clear();
+  
+  for (int l = 0; l < v; l++)
+    for (int h = 0; h < v; h++)
+      for (int w = 0; w < v; w++)
+	{
+	  int p = w + h*v + l*v*v;
+	  int q[3] = { w < n ? p + 1 : -1, h < n ? p + v : -1, l < n ? p + v*v : -1 };
+	  
+	  for (int i = 0; i < 3; i++)
+	    if ( q[i] >= 0 )
+	      springs.push_back( Spring(p, q[i], 2.5, 10.0,
+					(state[p].pos - state[q[i]].pos).norm()) );
+	}
+}
+
+/** Hexahedra with fibers joining opposite face centers
+    (bilinear coefs 0.5 on each face) */
+inline void makeHexaSprings(int n, const ps_v& state, hexaspring_v& hexasprings)
+{
+  // Faces -x +x -y +y -z +z, in cyclic order
+  const int faces[6][4] =
+    {
+      {0, 3, 7, 4}, {1, 2, 6, 5},
+      {0, 1, 5, 4}, {3, 2, 6, 7},
+      {0, 1, 2, 3}, {4, 5, 6, 7}
+    };
+  
+  Real coefs[6][4];
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 4; j++)
+      coefs[i][j] = 0.5;
+  
+  hexasprings.clear();
+  hexasprings.reserve(n*n*n);
+  
+  for (int l = 0; l < n; l++)
+    for (int h = 0; h < n; h++)
+      for (int w = 0; w < n; w++)
+	{
+	  int c[8];
+	  cubeVertices(n, w, h, l, c);
+	  
+	  Vec3 ip[6];
+	  for (int i = 0; i < 6; i++)
+	    ip[i] = Real(0.25)*( state[c[faces[i][0]]].pos + state[c[faces[i][1]]].pos +
+			   state[c[faces[i][2]]].pos + state[c[faces[i][3]]].pos );
+	  
+	  Vec3 g_pos = Vec3::null();
+	  for (int i = 0; i < 8; i++)
+	    g_pos += Real(0.125)*state[c[i]].pos;
+	  
+	  Real L[8];
+	  Real rest_length = 0.0;
+	  for (int i = 0; i < 8; i++)
+	    {
+	      L[i] = (state[c[i]].pos - g_pos).norm();
+	      rest_length += L[i];
+	    }
+	  
+	  hexasprings.push_back
+	    (
+	      HexaSpring( c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7],
+			  faces, coefs, 2.5, 2.5, 2.5, 2.5, 2.5, 2.5,
+			  10.0, 10.0, 10.0, 5.0, 10.0, rest_length,
+			  L[0], L[1], L[2], L[3], L[4], L[5], L[6], L[7],
+			  ip[0], ip[1], ip[2], ip[3], ip[4], ip[5] )
+	    );
+	}
+}
+
+/** Six tetrahedra per cube (split along the 0-6 diagonal),
+    with fibers joining face centroids */
+inline void makeTetraSprings(int n, const ps_v& state, tetraspring_v& tetrasprings)
+{
+  const int tetras[6][4] =
+    {
+      {0, 1, 2, 6}, {0, 2, 3, 6}, {0, 3, 7, 6},
+      {0, 7, 4, 6}, {0, 4, 5, 6}, {0, 5, 1, 6}
+    };
+  
+  // Local faces, by opposite vertex, and the face pairs of the fibers
+  const int faces[4][3] = { {1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2} };
+  const int pairs[6] = { 0, 1, 2, 3, 0, 2 };
+  
+  int vertex_indices[6][3];
+  Real coefs[6][3];
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 3; j++)
+      {
+	vertex_indices[i][j] = faces[pairs[i]][j];
+	coefs[i][j] = 1.0/3.0;
+      }
+  
+  tetrasprings.clear();
+  tetrasprings.reserve(6*n*n*n);
+  
+  for (int l = 0; l < n; l++)
+    for (int h = 0; h < n; h++)
+      for (int w = 0; w < n; w++)
+	{
+	  int c[8];
+	  cubeVertices(n, w, h, l, c);
+	  
+	  for (int t = 0; t < 6; t++)
+	    {
+	      Vec3 pos[4];
+	      for (int i = 0; i < 4; i++)
+		pos[i] = state[c[tetras[t][i]]].pos;
+	      
+	      Vec3 ip[6];
+	      for (int i = 0; i < 6; i++)
+		ip[i] = coefs[i][0]*pos[vertex_indices[i][0]] +
+		  coefs[i][1]*pos[vertex_indices[i][1]] +
+		  coefs[i][2]*pos[vertex_indices[i][2]];
+	      
+	      Vec3 g_pos = Real(0.25)*(pos[0] + pos[1] + pos[2] + pos[3]);
+	      
+	      Real rest_length = 0.0;
+	      for (int i = 0; i < 4; i++)
+		rest_length += (pos[i] - g_pos).norm();
+	      
+	      tetrasprings.push_back
+		(
+		  TetraSpring( c[tetras[t][0]], c[tetras[t][1]],
+			       c[tetras[t][2]], c[tetras[t][3]],
+			       vertex_indices, coefs, 2.5, 2.5, 2.5, 2.5, 2.5, 2.5,
+			       10.0, 10.0, 10.0, 5.0, rest_length,
+			       ip[0], ip[1], ip[2], ip[3], ip[4], ip[5] )
+		);
+	    }
+	}
+}
+
+#endif // BENCH_H
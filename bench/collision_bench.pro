@@ -0,0 +1,11 @@
+#
+# collision_bench.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on release
+DEFINES		= ALTERN DAMPED CONSTVOL
+INCLUDEPATH	= ..
+LIBS		+= -lpthread
+SOURCES		= collision_bench.C
+TARGET		= collision_bench
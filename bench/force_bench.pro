@@ -0,0 +1,11 @@
+#
+# force_bench.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on release
+DEFINES		= ALTERN DAMPED CONSTVOL
+INCLUDEPATH	= ..
+LIBS		+= -lpthread
+SOURCES		= force_bench.C
+TARGET		= force_bench
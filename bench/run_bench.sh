@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# run_bench.sh
+# Builds force_bench for every ALTERN/DAMPED/CONSTVOL combination,
+# in double, MIXED and SINGLE precision, and gathers the results
+# in one CSV file.
+#
+# Usage: run_bench.sh [max elements (1e6)] [min seconds (0.5)] [output (force_bench.csv)]
+# CXX and CXXFLAGS are taken from the environment.
+#
+
+MAX=${1:-1e6}
+MIN=${2:-0.5}
+OUT=${3:-force_bench.csv}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -DNDEBUG"}
+
+DIR=`dirname $0`
+TMP=${TMPDIR:-/tmp}/force_bench.$$
+
+rm -f $OUT
+
+for PRECISION in "" -DMIXED -DSINGLE; do
+for ALTERN in 0 1; do
+for DAMPED in 0 1; do
+for CONSTVOL in 0 1; do
+    FLAGS="$PRECISION -DALTERN=$ALTERN -DDAMPED=$DAMPED -DCONSTVOL=$CONSTVOL"
+    echo "force_bench $FLAGS" 1>&2
+
+    $CXX $CXXFLAGS $FLAGS -I$DIR/.. -o $TMP $DIR/force_bench.C -lpthread || exit 1
+
+    if [ -f $OUT ]; then
+	$TMP $MAX $MIN | tail -n +2 >> $OUT
+    else
+	$TMP $MAX $MIN > $OUT
+    fi || exit 1
+done
+done
+done
+done
+
+rm -f $TMP
@@ -0,0 +1,11 @@
+#
+# scaling_bench.pro
+# qmake project file
+#
+TEMPLATE	= app
+CONFIG		= warn_on release
+DEFINES		= ALTERN DAMPED CONSTVOL
+INCLUDEPATH	= ..
+LIBS		+= -lpthread
+SOURCES		= scaling_bench.C
+TARGET		= scaling_bench
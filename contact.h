@@ -0,0 +1,543 @@
+#ifndef CONTACT_H
+#define CONTACT_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <animal/geometry/uniform_grid.h>
+#include "particle.h"
+
+// Contact of the particles with static obstacles: planes (half
+// spaces), spheres and triangle meshes, read from a scene file (see
+// read()). Particles are points of a contact radius.
+//
+// Broad phase: spheres and triangles are put in a uniform grid once
+// (see animal::geometry::Uniform_Grid), each in the cells its box,
+// grown by the contact distance, overlaps. Every particle keeps its
+// cell and the obstacles found there: only the particles that moved
+// into another cell since the last step look the grid up again, and
+// particles of empty cells test nothing but the planes. Among the
+// triangles near a particle, only the deepest contact is kept, so that
+// triangles sharing an edge do not push twice.
+//
+// Response, per particle:
+//   penalty     force ks*depth - kd*(normal velocity) along the normal
+//               (see force(), called by the particle pass)
+//   projection  position moved out of the obstacle, normal velocity
+//               removed (inelastic), after each step (see project())
+// with Coulomb friction of coefficient mu in both cases. Velocities
+// are those of the state, as for the drag and the spring damping.
+//
+// force() and project() only change the cell of their own particle:
+// they may be called for different particles at the same time.
+class Contact
+{
+public:
+
+  typedef animal::geometry::Uniform_Grid Grid;
+
+  enum Response { PENALTY, PROJECTION };
+
+  Contact() : response(PROJECTION), ks(100.0), kd(1.0), mu(0.0),
+	      radius(0.01), thickness(0.1), cell_size(0.0)
+    {}
+
+  // Obstacles and parameters of a scene file; false (with a message)
+  // on error. One statement per line, # for comments:
+  //   plane X Y Z NX NY NZ     half space below the plane through
+  //                            (X, Y, Z) of normal (NX, NY, NZ)
+  //   sphere X Y Z R
+  //   mesh FILE                triangles of a Wavefront OBJ file (v
+  //                            and f lines, path relative to the
+  //                            scene file), outside on the counter
+  //                            clockwise side
+  //   response penalty KS KD   or: response projection (default)
+  //   friction MU              (0 by default)
+  //   radius R                 contact distance (0.01 m by default)
+  //   thickness T              depth behind a mesh face still pushed
+  //                            out (0.1 m by default)
+  //   cell H                   grid cell size (by default the mean
+  //                            size of the spheres and triangles)
+  bool read(const char* name);
+
+  // Number of particles, before any force() or project()
+  void resize(std::size_t n);
+
+  // Penalty force on particle i of state s, added to f (penalty
+  // response only)
+  void force(std::size_t i, const Particle_State& s, Vec3_Acc& f);
+
+  // Particle i of state s moved out of the obstacles, after a step
+  // (projection response only)
+  void project(std::size_t i, Particle_State& s);
+
+  // Scene summary
+  void print(std::ostream& out) const;
+
+private:
+
+  enum { MAX_HITS = 8 };
+
+  struct Plane { Vec3_Acc o, n; };
+  struct Sphere { Vec3_Acc c; Real_Acc r; };
+  struct Triangle { Vec3_Acc a, b, c, n; };
+
+  // Contact normal (out of the obstacle) and penetration depth
+  struct Hit
+  {
+    Vec3_Acc n;
+    Real_Acc depth;
+  };
+
+  // Cell of a particle, and the spheres and triangles found there
+  struct Particle_Cell
+  {
+    Grid::Cell c;
+    Grid::Index first, last; // in grid.items()
+  };
+
+  bool readMesh(const std::string& name);
+  void build();
+
+  // Contacts of particle i at p, at most MAX_HITS
+  int hits(std::size_t i, const Vec3_Acc& p, Hit h[]);
+
+  static Vec3_Acc closest(const Triangle& t, const Vec3_Acc& p);
+
+
+  Response response;
+  Real_Acc ks, kd, mu;
+  Real_Acc radius, thickness;
+  double cell_size; // 0 for the default
+
+  std::vector<Plane> planes;
+  std::vector<Sphere> spheres;   // items [0, spheres.size()) of the grid
+  std::vector<Triangle> triangles; // the next ones
+
+  Grid grid;
+  std::vector<Particle_Cell> cells; // of each particle
+};
+
+inline bool
+Contact::read(const char* name)
+{
+  std::ifstream file_in(name);
+  if ( !file_in )
+    {
+      fprintf(stderr, "Contact %s: cannot open file\n", name);
+      return false;
+    }
+
+  std::string dir(name);
+  std::string::size_type slash = dir.rfind('/');
+  dir.erase(slash == std::string::npos ? 0 : slash + 1);
+
+  std::string line;
+  int n = 0;
+
+  while ( std::getline(file_in, line) )
+    {
+      ++n;
+
+      std::string::size_type c = line.find('#');
+      if ( c != std::string::npos ) line.erase(c);
+
+      std::istringstream in(line);
+      std::string key;
+      if ( !(in >> key) ) continue;
+
+      bool ok = false;
+
+      if ( key == "plane" )
+	{
+	  Plane p;
+	  ok = in >> p.o[0] >> p.o[1] >> p.o[2] >> p.n[0] >> p.n[1] >> p.n[2] && p.n.norm() > 0.0;
+	  if ( ok )
+	    {
+	      p.n.normalize();
+	      planes.push_back(p);
+	    }
+	}
+      else if ( key == "sphere" )
+	{
+	  Sphere s;
+	  ok = in >> s.c[0] >> s.c[1] >> s.c[2] >> s.r && s.r > 0.0;
+	  if ( ok ) spheres.push_back(s);
+	}
+      else if ( key == "mesh" )
+	{
+	  std::string file;
+	  ok = bool(in >> file);
+	  if ( ok && !readMesh( file[0] == '/' ? file : dir + file ) ) return false;
+	}
+      else if ( key == "response" )
+	{
+	  std::string mode;
+	  in >> mode;
+	  if ( mode == "penalty" )
+	    {
+	      response = PENALTY;
+	      ok = in >> ks >> kd && ks > 0.0 && kd >= 0.0;
+	    }
+	  else if ( mode == "projection" )
+	    {
+	      response = PROJECTION;
+	      ok = true;
+	    }
+	}
+      else if ( key == "friction" )
+	ok = in >> mu && mu >= 0.0;
+      else if ( key == "radius" )
+	ok = in >> radius && radius >= 0.0;
+      else if ( key == "thickness" )
+	ok = in >> thickness && thickness >= 0.0;
+      else if ( key == "cell" )
+	ok = in >> cell_size && cell_size > 0.0;
+
+      std::string extra;
+      if ( !ok || in >> extra )
+	{
+	  fprintf(stderr, "Contact %s, line %d: expected plane, sphere, mesh, response, "
+		  "friction, radius, thickness or cell, and their values\n", name, n);
+	  return false;
+	}
+    }
+
+  build();
+
+  return true;
+}
+
+inline bool
+Contact::readMesh(const std::string& name)
+{
+  std::ifstream file_in(name.c_str());
+  if ( !file_in )
+    {
+      fprintf(stderr, "Contact %s: cannot open mesh file\n", name.c_str());
+      return false;
+    }
+
+  std::vector<Vec3_Acc> vertices;
+  std::string line;
+  int n = 0;
+
+  while ( std::getline(file_in, line) )
+    {
+      ++n;
+
+      std::istringstream in(line);
+      std::string key;
+      if ( !(in >> key) ) continue;
+
+      if ( key == "v" )
+	{
+	  Vec3_Acc v;
+	  if ( !(in >> v[0] >> v[1] >> v[2]) )
+	    {
+	      fprintf(stderr, "Contact %s, line %d: bad vertex\n", name.c_str(), n);
+	      return false;
+	    }
+	  vertices.push_back(v);
+	}
+      else if ( key == "f" )
+	{
+	  // Polygons as fans; indices from 1, negative from the last
+	  // vertex, followed by /texture/normal indices
+	  std::vector<long> face;
+	  std::string corner;
+
+	  while ( in >> corner )
+	    {
+	      long k = strtol(corner.c_str(), 0, 10);
+	      if ( k < 0 ) k += vertices.size() + 1;
+	      if ( k < 1 || k > long( vertices.size() ) )
+		{
+		  fprintf(stderr, "Contact %s, line %d: bad vertex index\n", name.c_str(), n);
+		  return false;
+		}
+	      face.push_back(k - 1);
+	    }
+
+	  for (std::size_t j = 2; j < face.size(); ++j)
+	    {
+	      Triangle t;
+	      t.a = vertices[ face[0] ];
+	      t.b = vertices[ face[j - 1] ];
+	      t.c = vertices[ face[j] ];
+	      t.n = animal::geometry::cross(t.b - t.a, t.c - t.a);
+
+	      if ( t.n.norm() > 0.0 ) // not degenerate
+		{
+		  t.n.normalize();
+		  triangles.push_back(t);
+		}
+	    }
+	}
+    }
+
+  return true;
+}
+
+inline void
+Contact::build()
+{
+  // Cells of about the size of the obstacles
+  double h = cell_size;
+  if ( h <= 0.0 )
+    {
+      double sum = 0.0;
+
+      for (std::size_t s = 0; s < spheres.size(); ++s)
+	sum += 2.0*spheres[s].r;
+
+      for (std::size_t t = 0; t < triangles.size(); ++t)
+	{
+	  const Triangle& tr = triangles[t];
+	  Real_Acc extent = 0.0;
+	  for (int d = 0; d < 3; ++d)
+	    extent = std::max( extent, std::max( std::max(tr.a[d], tr.b[d]), tr.c[d] )
+				       - std::min( std::min(tr.a[d], tr.b[d]), tr.c[d] ) );
+	  sum += extent;
+	}
+
+      std::size_t n = spheres.size() + triangles.size();
+      h = n ? sum/n : 1.0;
+      h = std::max(h, 2.0*double(radius + thickness));
+    }
+
+  grid.clear(h);
+
+  const Vec3_Acc margin(radius, radius, radius);
+
+  for (std::size_t s = 0; s < spheres.size(); ++s)
+    {
+      const Vec3_Acc r(spheres[s].r, spheres[s].r, spheres[s].r);
+      grid.add(s, spheres[s].c - r - margin, spheres[s].c + r + margin);
+    }
+
+  // Faces also reach thickness behind
+  const Real_Acc reach = std::max(radius, thickness);
+  const Vec3_Acc behind(reach, reach, reach);
+
+  for (std::size_t t = 0; t < triangles.size(); ++t)
+    {
+      const Triangle& tr = triangles[t];
+      Vec3_Acc lo, hi;
+
+      for (int d = 0; d < 3; ++d)
+	{
+	  lo[d] = std::min( std::min(tr.a[d], tr.b[d]), tr.c[d] );
+	  hi[d] = std::max( std::max(tr.a[d], tr.b[d]), tr.c[d] );
+	}
+
+      grid.add(spheres.size() + t, lo - behind, hi + behind);
+    }
+
+  grid.build();
+}
+
+inline void
+Contact::resize(std::size_t n)
+{
+  // In no cell yet: looked up at the first query
+  Particle_Cell none;
+  none.c.i = none.c.j = none.c.k = INT_MIN;
+  none.first = none.last = 0;
+
+  cells.assign(n, none);
+}
+
+// Closest point of triangle t to p (after Ericson, Real-Time Collision
+// Detection, 5.1.5)
+inline Vec3_Acc
+Contact::closest(const Triangle& t, const Vec3_Acc& p)
+{
+  using animal::geometry::dot;
+
+  Vec3_Acc ab = t.b - t.a, ac = t.c - t.a, ap = p - t.a;
+  Real_Acc d1 = dot(ab, ap), d2 = dot(ac, ap);
+  if ( d1 <= 0.0 && d2 <= 0.0 ) return t.a;
+
+  Vec3_Acc bp = p - t.b;
+  Real_Acc d3 = dot(ab, bp), d4 = dot(ac, bp);
+  if ( d3 >= 0.0 && d4 <= d3 ) return t.b;
+
+  Real_Acc vc = d1*d4 - d3*d2;
+  if ( vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0 )
+    return t.a + d1/(d1 - d3) * ab;
+
+  Vec3_Acc cp = p - t.c;
+  Real_Acc d5 = dot(ab, cp), d6 = dot(ac, cp);
+  if ( d6 >= 0.0 && d5 <= d6 ) return t.c;
+
+  Real_Acc vb = d5*d2 - d1*d6;
+  if ( vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0 )
+    return t.a + d2/(d2 - d6) * ac;
+
+  Real_Acc va = d3*d6 - d5*d4;
+  if ( va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0 )
+    return t.b + (d4 - d3)/((d4 - d3) + (d5 - d6)) * (t.c - t.b);
+
+  Real_Acc denom = 1.0/(va + vb + vc);
+  return t.a + (vb*denom) * ab + (vc*denom) * ac;
+}
+
+inline int
+Contact::hits(std::size_t i, const Vec3_Acc& p, Hit h[])
+{
+  using animal::geometry::dot;
+
+  int n = 0;
+
+  for (std::size_t k = 0; k < planes.size() && n < MAX_HITS; ++k)
+    {
+      Real_Acc d = dot(p - planes[k].o, planes[k].n);
+      if ( d < radius )
+	{
+	  h[n].n = planes[k].n;
+	  h[n].depth = radius - d;
+	  ++n;
+	}
+    }
+
+  // Obstacles of the cell, looked up again if the particle left it
+  Particle_Cell& pc = cells[i];
+  Grid::Cell c = grid.cell(p);
+  if ( c != pc.c )
+    {
+      pc.c = c;
+      grid.find(c, pc.first, pc.last);
+    }
+
+  Hit deepest;
+  deepest.n = Vec3_Acc::null();
+  deepest.depth = 0.0;
+
+  for (Grid::Index k = pc.first; k < pc.last && n < MAX_HITS; ++k)
+    {
+      const std::size_t item = grid.items()[k];
+
+      if ( item < spheres.size() )
+	{
+	  const Sphere& s = spheres[item];
+	  Vec3_Acc v = p - s.c;
+	  Real_Acc l = v.norm();
+
+	  if ( l - s.r < radius )
+	    {
+	      h[n].n = l > 0.0 ? v/l : Vec3_Acc(0.0, 1.0, 0.0);
+	      h[n].depth = radius - (l - s.r);
+	      ++n;
+	    }
+	}
+      else
+	{
+	  const Triangle& t = triangles[item - spheres.size()];
+	  Vec3_Acc v = p - closest(t, p);
+	  Real_Acc d = dot(v, t.n);
+	  Real_Acc l = v.norm();
+	  Hit hit;
+	  hit.n = Vec3_Acc::null();
+	  hit.depth = 0.0;
+
+	  if ( d >= 0.0 )
+	    {
+	      // In front: from the closest point
+	      if ( l < radius )
+		{
+		  hit.n = l > 0.0 ? v/l : t.n;
+		  hit.depth = radius - l;
+		}
+	    }
+	  else if ( -d < thickness && l + d < 1.0e-9*(1.0 - d) )
+	    {
+	      // Behind the face itself (not an edge): along its normal
+	      hit.n = t.n;
+	      hit.depth = radius - d;
+	    }
+
+	  if ( hit.depth > deepest.depth ) deepest = hit;
+	}
+    }
+
+  if ( deepest.depth > 0.0 && n < MAX_HITS ) h[n++] = deepest;
+
+  return n;
+}
+
+inline void
+Contact::force(std::size_t i, const Particle_State& s, Vec3_Acc& f)
+{
+  using animal::geometry::dot;
+
+  if ( response != PENALTY ) return;
+
+  Hit h[MAX_HITS];
+  int n = hits(i, Vec3_Acc(s.pos), h);
+
+  const Vec3_Acc vel(s.vel);
+
+  for (int k = 0; k < n; ++k)
+    {
+      Real_Acc vn = dot(vel, h[k].n);
+      Real_Acc fn = ks*h[k].depth - kd*vn;
+      if ( fn <= 0.0 ) continue; // no adhesion
+
+      f += fn * h[k].n;
+
+      // Friction: viscous below the Coulomb bound
+      Vec3_Acc vt = vel - vn * h[k].n;
+      Real_Acc lt = vt.norm();
+      if ( lt > 0.0 )
+	f -= ( std::min(mu*fn, kd*lt)/lt ) * vt;
+    }
+}
+
+inline void
+Contact::project(std::size_t i, Particle_State& s)
+{
+  using animal::geometry::dot;
+
+  if ( response != PROJECTION ) return;
+
+  Hit h[MAX_HITS];
+  int n = hits(i, Vec3_Acc(s.pos), h);
+
+  for (int k = 0; k < n; ++k)
+    {
+      s.pos += Vec3( h[k].depth * h[k].n );
+
+      Vec3_Acc vel(s.vel);
+      Real_Acc vn = dot(vel, h[k].n);
+      if ( vn >= 0.0 ) continue; // leaving
+
+      vel -= vn * h[k].n;
+
+      // Friction: the tangential velocity lost is at most mu times the
+      // normal one
+      Real_Acc lt = vel.norm();
+      if ( lt > 0.0 )
+	vel -= ( std::min(lt, -mu*vn)/lt ) * vel;
+
+      s.vel = Vec3(vel);
+    }
+}
+
+inline void
+Contact::print(std::ostream& out) const
+{
+  out << "Contact: " << planes.size() << " planes, " << spheres.size() << " spheres, "
+      << triangles.size() << " triangles in " << grid.ncells() << " cells of "
+      << grid.cellSize() << " m, "
+      << ( response == PENALTY ? "penalty" : "projection" ) << " response" << std::endl;
+}
+
+#endif // CONTACT_H
@@ -0,0 +1,325 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include <cstdio>
+#include <vector>
+#include <ostream>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <animal/integration/explicit_driver.h>
+#include <animal/geometry/partition.h>
+#include "scheme.h"
+
+// Domain decomposition over several processes of one host. The
+// elements are partitioned (see animal::geometry::Partition), and
+// each part is run by its own process, with its own Solver_Driver,
+// on the particles of its elements only, stored in vectors
+// allocated by that process.
+//
+// Particles of several parts (interface particles) are simulated
+// by each of these parts: after the element pass, every process
+// writes its partial forces on interface particles to its slots in
+// shared memory, waits for the others, then sums the slots of all
+// the parts, in part order. The sums, hence the steps, are the same
+// in every process, so positions need not be exchanged. Slots are
+// double buffered, one barrier per step is enough: a slot is only
+// written again two steps later, once every process is past the
+// barrier of the step in between.
+//
+// The final state of each particle is copied back by the part that
+// owns it. Particles of no element are simulated by part 0.
+template <class ElementT>
+class Domain
+{
+public:
+
+  typedef std::vector<Particle_State> State;
+  typedef std::vector<Particle_Model> Model;
+  typedef std::vector<ElementT> Elements;
+  typedef animal::integration::Euler<Particle_Traits,
+                                     Stoermer_Derivative<Elements>,
+                                     Stoermer_Step> Solver;
+  typedef animal::integration::Solver_Driver<Solver> Driver;
+
+  // The state, model and elements are those of the caller; the
+  // state is updated by run()
+  Domain(State& s, const Model& m, const Elements& e)
+    : state(s), model(m), elements(e)
+    {}
+
+  // Split the elements into nparts parts, run them from date t to
+  // end with steps of dt in nparts processes (this one and forked
+  // ones), and copy the final state back; false (with a message)
+  // on error
+  bool run(int nparts, double t, double dt, double end, std::ostream& out);
+
+  // Date reached by the last run()
+  double date() const { return final_date; }
+
+private:
+
+  struct Exchange : public Force_Exchange
+  {
+    Real_Acc* slots;     // 2 buffers of nparts slots of ninterface forces
+    pthread_barrier_t* barrier;
+    int rank, nparts;
+    std::size_t ninterface;
+
+    std::vector<unsigned int> local; // interface particles of the part
+    std::vector<unsigned int> index; // and their index among all interface particles
+
+    int parity; // buffer of the step
+
+    void operator()(Particle_Traits::Model_t& M);
+  };
+
+  void simulate(int rank, double t, double dt, double end);
+
+
+  State& state;
+  const Model& model;
+  const Elements& elements;
+
+  animal::geometry::Partition partition;
+  std::vector<int> interface; // index of each interface particle, -1 for the others
+
+  // Shared memory
+  void* shared;
+  pthread_barrier_t* barrier;
+  Real_Acc* slots;
+  Particle_State* final_state; // of all particles
+  double* final_dates;         // of each part
+
+  double final_date;
+};
+
+template <class ElementT>
+void
+Domain<ElementT>::Exchange::operator()(Particle_Traits::Model_t& M)
+{
+  Real_Acc* buffer = slots + parity*nparts*ninterface*3;
+  Real_Acc* mine = buffer + rank*ninterface*3;
+
+  for (std::size_t i = 0; i < local.size(); ++i)
+    {
+      const Vec3_Acc& f = M[ local[i] ].f;
+      Real_Acc* s = mine + 3*index[i];
+
+      s[0] = f[0]; s[1] = f[1]; s[2] = f[2];
+    }
+
+  pthread_barrier_wait(barrier);
+
+  for (std::size_t i = 0; i < local.size(); ++i)
+    {
+      Vec3_Acc f = Vec3_Acc::null();
+
+      for (int p = 0; p < nparts; ++p)
+	{
+	  const Real_Acc* s = buffer + 3*(p*ninterface + index[i]);
+	  f += Vec3_Acc(s[0], s[1], s[2]);
+	}
+
+      M[ local[i] ].f = f;
+    }
+
+  parity ^= 1;
+}
+
+template <class ElementT>
+bool
+Domain<ElementT>::run(int nparts, double t, double dt, double end, std::ostream& out)
+{
+  const std::size_t n = state.size();
+
+  for (typename Elements::size_type e = 0; e < elements.size(); ++e)
+    {
+      animal::geometry::Partition::Index v[ElementT::NPARTICLES];
+
+      for (int i = 0; i < ElementT::NPARTICLES; ++i)
+	v[i] = elements[e].particle(i);
+
+      partition.addElement(ElementT::NPARTICLES, v);
+    }
+
+  partition.split(nparts);
+
+  interface.assign(n, -1);
+  std::size_t ninterface = 0;
+  for (std::size_t i = 0; i < n && i < partition.owners().size(); ++i)
+    if ( partition.isInterface(i) ) interface[i] = ninterface++;
+
+  std::vector<int> sizes(nparts, 0);
+  for (std::size_t e = 0; e < partition.parts().size(); ++e)
+    ++sizes[ partition.parts()[e] ];
+
+  out << nparts << " parts of";
+  for (int p = 0; p < nparts; ++p)
+    out << " " << sizes[p];
+  out << " elements, " << ninterface << " interface particles" << std::endl;
+
+  // Barrier, force slots, final states and dates, on cache lines
+  const std::size_t line = 64;
+  const std::size_t slots_at = (sizeof(pthread_barrier_t) + line - 1)/line*line;
+  const std::size_t state_at = (slots_at + 2*nparts*ninterface*3*sizeof(Real_Acc) + line - 1)/line*line;
+  const std::size_t dates_at = (state_at + n*sizeof(Particle_State) + line - 1)/line*line;
+  const std::size_t size = dates_at + nparts*sizeof(double);
+
+  shared = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if ( shared == MAP_FAILED )
+    {
+      perror("Domain: shared memory");
+      return false;
+    }
+
+  char* first = static_cast<char*>(shared);
+  barrier = reinterpret_cast<pthread_barrier_t*>(first);
+  slots = reinterpret_cast<Real_Acc*>(first + slots_at);
+  final_state = reinterpret_cast<Particle_State*>(first + state_at);
+  final_dates = reinterpret_cast<double*>(first + dates_at);
+
+  for (std::size_t i = 0; i < 2*nparts*ninterface*3; ++i)
+    slots[i] = 0.0;
+
+  pthread_barrierattr_t attr;
+  pthread_barrierattr_init(&attr);
+  pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(barrier, &attr, nparts);
+  pthread_barrierattr_destroy(&attr);
+
+  out.flush();
+  fflush(0); // not to be written again by the children
+
+  std::vector<pid_t> children;
+  bool failed = false;
+
+  for (int rank = 1; rank < nparts; ++rank)
+    {
+      pid_t pid = fork();
+
+      if ( pid == 0 )
+	{
+	  simulate(rank, t, dt, end);
+	  _exit(0); // no destructors, no buffers flushed: those are the parent's
+	}
+
+      if ( pid < 0 )
+	{
+	  perror("Domain: fork");
+	  failed = true;
+
+	  for (std::size_t i = 0; i < children.size(); ++i)
+	    kill(children[i], SIGKILL); // would wait for the missing parts forever
+	  break;
+	}
+
+      children.push_back(pid);
+    }
+
+  if ( !failed )
+    simulate(0, t, dt, end);
+
+  for (std::size_t i = 0; i < children.size(); ++i)
+    {
+      int status;
+      if ( waitpid(children[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) )
+	failed = true;
+    }
+
+  if ( !failed )
+    {
+      for (std::size_t i = 0; i < n; ++i)
+	state[i] = final_state[i];
+
+      final_date = final_dates[0];
+    }
+  else
+    fprintf(stderr, "Domain: a part failed\n");
+
+  pthread_barrier_destroy(barrier);
+  munmap(shared, size);
+
+  return !failed;
+}
+
+template <class ElementT>
+void
+Domain<ElementT>::simulate(int rank, double t, double dt, double end)
+{
+  const std::vector<int>& parts = partition.parts();
+  const std::vector<int>& owners = partition.owners();
+  const std::size_t n = state.size();
+
+  // Particles of the part, in the global order
+  std::vector<bool> touched(n, false);
+  Elements E;
+
+  for (typename Elements::size_type e = 0; e < elements.size(); ++e)
+    if ( parts[e] == rank )
+      {
+	E.push_back( elements[e] );
+
+	for (int i = 0; i < ElementT::NPARTICLES; ++i)
+	  touched[ elements[e].particle(i) ] = true;
+      }
+
+  if ( rank == 0 )
+    for (std::size_t i = 0; i < n; ++i)
+      if ( i >= owners.size() || owners[i] < 0 ) touched[i] = true;
+
+  std::vector<unsigned int> local(n, static_cast<unsigned int>(-1));
+  std::vector<unsigned int> global;
+  State S;
+  Model M;
+
+  for (std::size_t i = 0; i < n; ++i)
+    if ( touched[i] )
+      {
+	local[i] = global.size();
+	global.push_back(i);
+	S.push_back( state[i] );
+	M.push_back( model[i] );
+      }
+
+  for (typename Elements::size_type e = 0; e < E.size(); ++e)
+    E[e].renumber(local);
+
+  Exchange exchange;
+  exchange.slots = slots;
+  exchange.barrier = barrier;
+  exchange.rank = rank;
+  exchange.nparts = partition.nparts();
+  exchange.ninterface = 0;
+  exchange.parity = 0;
+
+  for (std::size_t i = 0; i < n; ++i)
+    if ( interface[i] >= 0 ) ++exchange.ninterface;
+
+  for (std::size_t l = 0; l < global.size(); ++l)
+    if ( interface[ global[l] ] >= 0 )
+      {
+	exchange.local.push_back(l);
+	exchange.index.push_back( interface[ global[l] ] );
+      }
+
+  Solver solve( S, Stoermer_Derivative<Elements>(E, &exchange), Stoermer_Step() );
+  Driver drive(solve, t, dt);
+
+  while ( drive.date < end - 0.5*dt )
+    drive(M, S);
+
+  for (std::size_t l = 0; l < global.size(); ++l)
+    {
+      unsigned int i = global[l];
+
+      if ( ( i >= owners.size() || owners[i] < 0 ) ? rank == 0 : owners[i] == rank )
+	final_state[i] = S[l];
+    }
+
+  final_dates[rank] = drive.date;
+}
+
+#endif // DOMAIN_H
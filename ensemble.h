@@ -0,0 +1,305 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <animal/integration/explicit_driver.h>
+#include "scheme.h"
+
+// Elements of a mesh, read only: a view on the vector built by
+// parse(), shared by the derivatives of all the ensemble members
+// instead of one copy each.
+template <class T>
+struct Element_View
+{
+  typedef T value_type;
+  typedef const T* iterator;
+  typedef std::size_t size_type;
+
+  Element_View() : first(0), last(0)
+    {}
+  Element_View(const std::vector<T>& v)
+    : first( v.empty() ? 0 : &v[0] ), last( first + v.size() )
+    {}
+
+  iterator begin() const { return first; }
+  iterator end() const { return last; }
+  size_type size() const { return last - first; }
+
+private:
+
+  const T* first;
+  const T* last;
+};
+
+// Parameter sweep over one mesh: the members share the mesh
+// topology and the elements (vertex indices, interpolation
+// coefficients, rest lengths), and have their own state, model
+// and table of constants (see Fiber_Params::use()).
+//
+// Members are read from a file, one per line: assignments of
+// some constants, e.g. "ks1=2.5 ks4=1 kvs=5", the others keep
+// the values of the mesh ('#' starts a comment). Members are run
+// to the end date by a number of threads, each one taking the
+// next member not run yet; the results are written in member
+// order once all are done.
+template <class ElementT>
+class Ensemble
+{
+public:
+
+  typedef std::vector<Particle_State> State;
+  typedef std::vector<Particle_Model> Model;
+  typedef animal::integration::Euler<Particle_Traits,
+                                     Stoermer_Derivative< Element_View<ElementT> >,
+                                     Stoermer_Step> Solver;
+  typedef animal::integration::Solver_Driver<Solver> Driver;
+
+  // The initial state, model and elements are those of the caller,
+  // which must keep them until run() returns
+  Ensemble(const State& s, const Model& m, const std::vector<ElementT>& e)
+    : state(s), model(m), elements(e)
+    {}
+
+  // Members from file name, with constants based on the current
+  // Fiber_Params::table(); false (with a message) on error
+  bool read(const char* name);
+
+  // Number of members
+  std::size_t size() const { return members.size(); }
+
+  // Run every member from date t to end, with steps of dt, on jobs
+  // threads (0 for one per processor), and write the results to out
+  void run(double t, double dt, double end, int jobs, std::ostream& out);
+
+private:
+
+  struct Member
+  {
+    std::string line;                 // assignments, as read
+    std::vector<Fiber_Params> params; // table of the member
+
+    Vec3_Acc centroid;  // of the final positions
+    Real_Acc max_dist;  // largest displacement from the initial position
+    double wall;        // time to run the member (in s)
+    bool failed;        // non finite positions
+  };
+
+  static Real Fiber_Params::* field(const char* name);
+
+  static void* work(void* ensemble);
+  void simulate(Member& m);
+
+
+  const State& state;
+  const Model& model;
+  const std::vector<ElementT>& elements;
+
+  std::vector<Member> members;
+
+  double date, time_step, end_date;
+
+  std::size_t next; // member to run
+  pthread_mutex_t lock;
+};
+
+template <class ElementT>
+Real Fiber_Params::*
+Ensemble<ElementT>::field(const char* name)
+{
+  static const struct { const char* name; Real Fiber_Params::* field; } fields[] =
+    {
+      { "ks1", &Fiber_Params::ks1 }, { "ks2", &Fiber_Params::ks2 },
+      { "ks3", &Fiber_Params::ks3 }, { "ks4", &Fiber_Params::ks4 },
+      { "ks5", &Fiber_Params::ks5 }, { "ks6", &Fiber_Params::ks6 },
+      { "kd1", &Fiber_Params::kd1 }, { "kd2", &Fiber_Params::kd2 },
+      { "kd3", &Fiber_Params::kd3 },
+      { "kvs", &Fiber_Params::ks },  { "kvd", &Fiber_Params::kd }
+    };
+
+  for (std::size_t i = 0; i < sizeof(fields)/sizeof(fields[0]); ++i)
+    if ( !strcmp(name, fields[i].name) ) return fields[i].field;
+
+  return 0;
+}
+
+template <class ElementT>
+bool
+Ensemble<ElementT>::read(const char* name)
+{
+  std::ifstream file_in(name);
+  if ( !file_in )
+    {
+      fprintf(stderr, "Ensemble %s: cannot open file\n", name);
+      return false;
+    }
+
+  std::string line;
+  int n = 0;
+
+  while ( std::getline(file_in, line) )
+    {
+      ++n;
+
+      std::string::size_type c = line.find('#');
+      if ( c != std::string::npos ) line.erase(c);
+
+      std::vector<char> buffer( line.begin(), line.end() );
+      buffer.push_back('\0');
+
+      Member m;
+      m.params = Fiber_Params::table();
+      m.failed = false;
+
+      bool empty = true;
+
+      for (char* a = strtok(&buffer[0], " \t\r"); a; a = strtok(0, " \t\r"))
+	{
+	  char* v = strchr(a, '=');
+	  if ( v ) *v++ = '\0';
+
+	  Real Fiber_Params::* f = field(a);
+	  char* e = 0;
+	  double x = v ? strtod(v, &e) : 0.0;
+
+	  if ( !f || !v || e == v || *e )
+	    {
+	      fprintf(stderr, "Ensemble %s, line %d: expected name=value, name among "
+		      "ks1..ks6, kd1..kd3, kvs, kvd\n", name, n);
+	      return false;
+	    }
+
+	  for (std::vector<Fiber_Params>::size_type i = 0; i < m.params.size(); ++i)
+	    m.params[i].*f = x;
+
+	  if ( !m.line.empty() ) m.line += ' ';
+	  m.line += a;
+	  m.line += '=';
+	  m.line += v;
+	  empty = false;
+	}
+
+      if ( !empty ) members.push_back(m);
+    }
+
+  if ( members.empty() )
+    {
+      fprintf(stderr, "Ensemble %s: no member\n", name);
+      return false;
+    }
+
+  return true;
+}
+
+template <class ElementT>
+void
+Ensemble<ElementT>::run(double t, double dt, double end, int jobs, std::ostream& out)
+{
+  date = t;
+  time_step = dt;
+  end_date = end;
+  next = 0;
+
+  if ( jobs <= 0 ) jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  if ( jobs > static_cast<int>( members.size() ) ) jobs = members.size();
+  if ( jobs < 1 ) jobs = 1;
+
+  out << members.size() << " members on " << jobs << " threads" << std::endl;
+
+  pthread_mutex_init(&lock, 0);
+
+  std::vector<pthread_t> threads(jobs);
+
+  for (int i = 0; i < jobs; ++i)
+    pthread_create(&threads[i], 0, work, this);
+
+  for (int i = 0; i < jobs; ++i)
+    pthread_join(threads[i], 0);
+
+  pthread_mutex_destroy(&lock);
+
+  out << "member\tcx\tcy\tcz\tmax displacement\twall time\tparameters" << std::endl;
+
+  for (std::size_t i = 0; i < members.size(); ++i)
+    {
+      const Member& m = members[i];
+
+      out << i << '\t';
+      if ( m.failed )
+	out << "nan\tnan\tnan\tnan";
+      else
+	out << m.centroid[0] << '\t' << m.centroid[1] << '\t' << m.centroid[2] << '\t'
+	    << m.max_dist;
+      out << '\t' << m.wall << '\t' << m.line << std::endl;
+    }
+}
+
+template <class ElementT>
+void*
+Ensemble<ElementT>::work(void* ensemble)
+{
+  Ensemble& e = *static_cast<Ensemble*>(ensemble);
+
+  for (;;)
+    {
+      pthread_mutex_lock(&e.lock);
+      std::size_t i = e.next++;
+      pthread_mutex_unlock(&e.lock);
+
+      if ( i >= e.members.size() ) break;
+
+      e.simulate(e.members[i]);
+    }
+
+  Fiber_Params::use(0);
+  return 0;
+}
+
+template <class ElementT>
+void
+Ensemble<ElementT>::simulate(Member& m)
+{
+  timeval start, stop;
+  gettimeofday(&start, 0);
+
+  State S(state);
+  Model M(model);
+
+  Fiber_Params::use(&m.params); // read by the elements, on this thread
+
+  Solver solve( S,
+		Stoermer_Derivative< Element_View<ElementT> >(elements),
+		Stoermer_Step() );
+  Driver drive(solve, date, time_step);
+
+  while ( drive.date < end_date - 0.5*time_step )
+    drive(M, S);
+
+  m.centroid = Vec3_Acc::null();
+  m.max_dist = 0.0;
+
+  for (typename State::size_type i = 0; i < S.size(); ++i)
+    {
+      m.centroid += Vec3_Acc( S[i].pos );
+
+      Real_Acc d = Vec3_Acc( S[i].pos - state[i].pos ).norm();
+      if ( !(d <= m.max_dist) ) m.max_dist = d; // NaN included
+    }
+
+  if ( !S.empty() ) m.centroid /= Real_Acc( S.size() );
+  m.failed = !( m.max_dist < HUGE_VAL ); // NaN or infinite
+
+  gettimeofday(&stop, 0);
+  m.wall = (stop.tv_sec - start.tv_sec) + 1.0e-06*(stop.tv_usec - start.tv_usec);
+}
+
+#endif // ENSEMBLE_H
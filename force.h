@@ -3,10 +3,12 @@
 
 #include <animal/geometry/vec3.h>
 
-template <class TraitsT>
+// RealT is the precision of the element computations,
+// by default the time representation of the traits
+template <class TraitsT, class RealT = typename TraitsT::Real_t>
 struct Force_Function
 {
-  typedef typename TraitsT::Real_t       Real_t;
+  typedef RealT                          Real_t;
   typedef typename TraitsT::Model_t      Model_t;
   typedef typename TraitsT::State_t      State_t;
   typedef typename TraitsT::Derivative_t Derivative_t;
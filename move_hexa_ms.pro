@@ -4,8 +4,8 @@
 #
 TEMPLATE	= app
 CONFIG		= opengl warn_on debug
-DEFINES		= DAMPED # BENCHMARK
+DEFINES		= DAMPED # MIXED SINGLE ANIMAL_SIMD
 INCLUDEPATH	= .
-LIBS		+= -lglut -lGLU
+LIBS		+= -lglut -lGLU -lEGL -lpthread
 SOURCES		= move_hexa_ms.C
 TARGET		= move_hexa_ms
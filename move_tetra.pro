@@ -4,8 +4,8 @@
 #
 TEMPLATE	= app
 CONFIG		= opengl warn_on debug
-DEFINES		= ALTERN DAMPED CONSTVOL # SURFACE VOLINFO BENCHMARK MEASURE
+DEFINES		= ALTERN DAMPED CONSTVOL # SURFACE VOLINFO MEASURE MIXED SINGLE ANIMAL_SIMD
 INCLUDEPATH	= .
-LIBS		+= -lglut -lGLU
+LIBS		+= -lglut -lGLU -lEGL -lpthread
 SOURCES		= intersect_triangle.c move_tetra.C
 TARGET		= move_tetra
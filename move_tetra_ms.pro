@@ -4,8 +4,8 @@
 #
 TEMPLATE	= app
 CONFIG		= opengl warn_on debug
-DEFINES		= DAMPED # VOLINFO BENCHMARK MEASURE
+DEFINES		= DAMPED # VOLINFO MEASURE MIXED SINGLE ANIMAL_SIMD
 INCLUDEPATH	= .
-LIBS		+= -lglut -lGLU
+LIBS		+= -lglut -lGLU -lEGL -lpthread
 SOURCES		= move_tetra_ms.C
 TARGET		= move_tetra_ms
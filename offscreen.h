@@ -0,0 +1,127 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <cstdio>
+#include <vector>
+#include <animal/support/async_writer.h>
+
+// OpenGL context without window system (no X server needed),
+// rendering into an EGL pbuffer; Mesa provides a software
+// rasterizer when there is no GPU. Frames are read back and
+// appended, as binary PPM images, to a stream written by a
+// background thread, e.g. to encode a movie with
+//   ffmpeg -f image2pipe -c:v ppm -r 25 -i frames.ppm movie.mp4
+
+class Offscreen
+{
+public:
+
+  Offscreen()
+    : display(EGL_NO_DISPLAY), surface(EGL_NO_SURFACE), context(EGL_NO_CONTEXT),
+      width(0), height(0), out(1 << 20, 8)
+    {}
+
+  ~Offscreen()
+    {
+      out.close();
+
+      if ( display == EGL_NO_DISPLAY ) return;
+
+      eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      if ( context != EGL_NO_CONTEXT ) eglDestroyContext(display, context);
+      if ( surface != EGL_NO_SURFACE ) eglDestroySurface(display, surface);
+      eglTerminate(display);
+    }
+
+  // Make a w x h context current for the calling thread, and open
+  // the frame stream; false (with a message) on error
+  bool open(int w, int h, const char* name)
+    {
+      display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+      // Without X server, ask Mesa for a display without platform
+      if ( !eglInitialize(display, 0, 0) )
+	{
+	  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+	    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>
+	    ( eglGetProcAddress("eglGetPlatformDisplayEXT") );
+
+	  display = getPlatformDisplay ?
+	    getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0) :
+	    EGL_NO_DISPLAY;
+
+	  if ( display == EGL_NO_DISPLAY || !eglInitialize(display, 0, 0) )
+	    return failed("cannot initialize EGL");
+	}
+
+      const EGLint config_attribs[] = {
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+	EGL_NONE };
+
+      EGLConfig config;
+      EGLint nconfig;
+
+      if ( !eglChooseConfig(display, config_attribs, &config, 1, &nconfig) || nconfig < 1 )
+	return failed("no pbuffer configuration");
+
+      const EGLint pbuffer_attribs[] = { EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE };
+
+      surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+      if ( surface == EGL_NO_SURFACE ) return failed("cannot create pbuffer");
+
+      eglBindAPI(EGL_OPENGL_API);
+
+      context = eglCreateContext(display, config, EGL_NO_CONTEXT, 0);
+      if ( context == EGL_NO_CONTEXT ) return failed("cannot create context");
+
+      if ( !eglMakeCurrent(display, surface, surface, context) )
+	return failed("cannot make context current");
+
+      if ( !out.open(name, "wb") ) return failed("cannot open frame file");
+
+      width = w;
+      height = h;
+      pixels.resize(3*w*h);
+
+      return true;
+    }
+
+  // Read the current frame back and queue it; the file is written
+  // by the Async_Writer thread
+  void writeFrame()
+    {
+      glFinish();
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+      out.printf("P6\n%d %d\n255\n", width, height);
+
+      // OpenGL rows go upwards, PPM rows downwards
+      for (int y = height - 1; y >= 0; --y)
+	out.write(&pixels[3*width*y], 3*width);
+    }
+
+private:
+
+  bool failed(const char* what)
+    {
+      fprintf(stderr, "Offscreen: %s (EGL error 0x%x)\n", what, eglGetError());
+      return false;
+    }
+
+  EGLDisplay display;
+  EGLSurface surface;
+  EGLContext context;
+
+  int width, height;
+  std::vector<unsigned char> pixels;
+
+  animal::support::Async_Writer out;
+};
+
+#endif // OFFSCREEN_H
@@ -0,0 +1,94 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Command line options common to the move_* programs.
+// They are removed from argv, leaving the positional arguments
+// (mesh and faces files) to each program parse().
+
+struct Options
+{
+  double batch;       // simulated time to run without display (in s), 0 for interactive
+  const char* capture; // with batch, file of rendered frames (offscreen), 0 for none
+  const char* camera;  // camera script for captures (see Camera_Script), 0 for none
+  int width, height;   // of captured frames
+  int fibers;          // max number of fibers drawn (subsampled beyond), 0 for none
+  double skin;         // stiffness of springs added along the boundary edges, 0 for none
+  const char* checkpoint; // file of periodic checkpoints, 0 for none
+  double every;           // simulated time between checkpoints (in s)
+  const char* restart;    // checkpoint to start from, instead of the mesh files
+  const char* trajectory; // file of recorded positions and velocities, 0 for none
+  int stride;             // steps between recorded frames
+  double quantum;         // precision of recorded positions (in m)
+  const char* ensemble;   // with batch, file of parameter sets to run, 0 for none
+  int jobs;               // threads running the ensemble, 0 for one per processor
+  int partitions;         // with batch, processes sharing the mesh, 1 for a single one
+  int threads;            // workers of the solver passes, 0 for one per processor
+  const char* contact;    // file of obstacles (see Contact), 0 for none
+  bool collisions;        // detect the self-collisions of the surface (see Self_Collision)
+  bool skipflat;          // with collisions, skip its flat patches (faster, may miss pairs)
+
+  Options() : batch(0.0), capture(0), camera(0), width(512), height(512), fibers(10000),
+	      skin(0.0), checkpoint(0), every(10.0), restart(0),
+	      trajectory(0), stride(1), quantum(1.0e-6),
+	      ensemble(0), jobs(0), partitions(1), threads(1), contact(0),
+	      collisions(false), skipflat(false)
+    {}
+
+  void parse(int& argc, char** argv)
+    {
+      int n = 1;
+
+      for (int i = 1; i < argc; ++i)
+	{
+	  if ( !strcmp(argv[i], "-batch") && i + 1 < argc )
+	    batch = atof(argv[++i]);
+	  else if ( !strcmp(argv[i], "-capture") && i + 1 < argc )
+	    capture = argv[++i];
+	  else if ( !strcmp(argv[i], "-camera") && i + 1 < argc )
+	    camera = argv[++i];
+	  else if ( !strcmp(argv[i], "-size") && i + 1 < argc )
+	    sscanf(argv[++i], "%dx%d", &width, &height);
+	  else if ( !strcmp(argv[i], "-fibers") && i + 1 < argc )
+	    fibers = atoi(argv[++i]);
+	  else if ( !strcmp(argv[i], "-skin") && i + 1 < argc )
+	    skin = atof(argv[++i]);
+	  else if ( !strcmp(argv[i], "-checkpoint") && i + 1 < argc )
+	    checkpoint = argv[++i];
+	  else if ( !strcmp(argv[i], "-every") && i + 1 < argc )
+	    every = atof(argv[++i]);
+	  else if ( !strcmp(argv[i], "-restart") && i + 1 < argc )
+	    restart = argv[++i];
+	  else if ( !strcmp(argv[i], "-trajectory") && i + 1 < argc )
+	    trajectory = argv[++i];
+	  else if ( !strcmp(argv[i], "-stride") && i + 1 < argc )
+	    stride = atoi(argv[++i]);
+	  else if ( !strcmp(argv[i], "-quantum") && i + 1 < argc )
+	    quantum = atof(argv[++i]);
+	  else if ( !strcmp(argv[i], "-ensemble") && i + 1 < argc )
+	    ensemble = argv[++i];
+	  else if ( !strcmp(argv[i], "-jobs") && i + 1 < argc )
+	    jobs = atoi(argv[++i]);
+	  else if ( !strcmp(argv[i], "-partitions") && i + 1 < argc )
+	    partitions = atoi(argv[++i]);
+	  else if ( !strcmp(argv[i], "-threads") && i + 1 < argc )
+	    threads = atoi(argv[++i]);
+	  else if ( !strcmp(argv[i], "-contact") && i + 1 < argc )
+	    contact = argv[++i];
+	  else if ( !strcmp(argv[i], "-collisions") )
+	    collisions = true;
+	  else if ( !strcmp(argv[i], "-skipflat") )
+	    skipflat = true;
+	  else
+	    argv[n++] = argv[i];
+	}
+
+      argc = n;
+      argv[argc] = 0;
+    }
+};
+
+#endif // OPTIONS_H
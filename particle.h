@@ -5,8 +5,24 @@
 #include <GL/gl.h>
 #include <animal/geometry/vec3.h>
 
+/* Precision (may be set at compile time, e.g. -DMIXED=1):
+   default  double storage and computations
+   MIXED    float storage and element computations, double
+            accumulation of forces and volume
+   SINGLE   float everywhere
+   Time and the display camera stay double in every mode. */
+#if SINGLE || MIXED
+typedef GLfloat Real;      // particle data and element computations
+#else
 typedef GLdouble Real;
+#endif
+#if SINGLE
+typedef GLfloat Real_Acc;
+#else
+typedef GLdouble Real_Acc; // accumulated sums (forces, volume, energies)
+#endif
 typedef animal::geometry::Vec3<Real> Vec3;
+typedef animal::geometry::Vec3<Real_Acc> Vec3_Acc;
 
 struct Particle_State
 {
@@ -65,8 +81,8 @@ struct Particle_State_Derivative
 
 struct Particle_Model
 {
-  Real m;  // particle mass (in kg)
-  Vec3 f;  // particle force (in N)
+  Real m;      // particle mass (in kg)
+  Vec3_Acc f;  // particle force (in N), sum of the element forces
   
   Particle_Model() : m(), f()
     {}
@@ -0,0 +1,171 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+// Include before any other OpenGL header, for the OpenGL 1.5
+// buffer object prototypes
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "snapshot.h"
+
+// Draws snapshots with vertex arrays: positions are streamed
+// once per frame into a vertex buffer, edges and surface
+// triangles are index buffers uploaded once. Falls back to
+// client-side vertex arrays (OpenGL 1.1) when buffer objects
+// are not available.
+
+class Renderer
+{
+public:
+
+  Renderer()
+    : use_buffers(false), nedges(0), ntriangles(0)
+    {}
+
+  // Needs a current OpenGL context
+  void init()
+    {
+      const char* version = reinterpret_cast<const char*>( glGetString(GL_VERSION) );
+      const char* extensions = reinterpret_cast<const char*>( glGetString(GL_EXTENSIONS) );
+
+      int major = 1, minor = 0;
+      if ( version ) sscanf(version, "%d.%d", &major, &minor);
+
+      use_buffers = ( major > 1 || minor >= 5 ||
+		      ( extensions && strstr(extensions, "GL_ARB_vertex_buffer_object") ) );
+
+      if ( use_buffers )
+	{
+	  glGenBuffers(4, buffers);
+	  uploadIndices();
+	}
+    }
+
+  // Edges, from a vector of edge_index
+  template <class Edge_Container>
+  void setEdges(const Edge_Container& E)
+    {
+      edges.clear();
+      edges.reserve( 2*E.size() );
+
+      for (typename Edge_Container::const_iterator firste = E.begin();
+	   firste != E.end();
+	   ++firste)
+	{
+	  edges.push_back( (*firste).p0 );
+	  edges.push_back( (*firste).p1 );
+	}
+
+      nedges = edges.size();
+      if ( use_buffers ) uploadIndices();
+    }
+
+  // Surface triangles, three indices each
+  void setTriangles(const std::vector<GLuint>& T)
+    {
+      triangles = T;
+
+      ntriangles = triangles.size();
+      if ( use_buffers ) uploadIndices();
+    }
+
+  void draw(const Snapshot& s, bool points)
+    {
+      glEnableClientState(GL_VERTEX_ARRAY);
+
+      // Particles
+      vertexArray(POSITIONS, s.pos);
+
+      if ( ntriangles )
+	{
+	  glColor3f(0.1, 0.1, 0.3);
+	  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	  drawElements(GL_TRIANGLES, TRIANGLES, triangles, ntriangles);
+	}
+
+      glColor3f(1.0, 1.0, 0.0);
+
+      if ( points )
+	{
+	  glPointSize(5.0);
+	  glDrawArrays(GL_POINTS, 0, s.pos.size()/3);
+	}
+
+      drawElements(GL_LINES, EDGES, edges, nedges);
+
+      // Fibers
+      if ( !s.fibers.empty() )
+	{
+	  glColor3f(1.0, 0.0, 1.0);
+	  vertexArray(FIBERS, s.fibers);
+	  glDrawArrays(GL_LINES, 0, s.fibers.size()/3);
+	}
+
+      if ( use_buffers )
+	{
+	  glBindBuffer(GL_ARRAY_BUFFER, 0);
+	  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+      glDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+private:
+
+  enum { POSITIONS = 0, FIBERS, EDGES, TRIANGLES };
+
+  void uploadIndices()
+    {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[EDGES]);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, edges.size()*sizeof(GLuint),
+		   edges.empty() ? 0 : &edges[0], GL_STATIC_DRAW);
+
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[TRIANGLES]);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size()*sizeof(GLuint),
+		   triangles.empty() ? 0 : &triangles[0], GL_STATIC_DRAW);
+
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+  // Stream coords into buffer b and point the vertex array to it
+  void vertexArray(int b, const std::vector<GLfloat>& coords)
+    {
+      if ( coords.empty() ) return;
+
+      if ( use_buffers )
+	{
+	  glBindBuffer(GL_ARRAY_BUFFER, buffers[b]);
+	  glBufferData(GL_ARRAY_BUFFER, coords.size()*sizeof(GLfloat),
+		       &coords[0], GL_STREAM_DRAW);
+	  glVertexPointer(3, GL_FLOAT, 0, 0);
+	}
+      else
+	glVertexPointer(3, GL_FLOAT, 0, &coords[0]);
+    }
+
+  void drawElements(GLenum mode, int b, const std::vector<GLuint>& indices, GLsizei n)
+    {
+      if ( n == 0 ) return;
+
+      if ( use_buffers )
+	{
+	  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[b]);
+	  glDrawElements(mode, n, GL_UNSIGNED_INT, 0);
+	}
+      else
+	glDrawElements(mode, n, GL_UNSIGNED_INT, &indices[0]);
+    }
+
+  bool use_buffers;
+  GLuint buffers[4];
+
+  std::vector<GLuint> edges;     // kept for the vertex array fallback
+  std::vector<GLuint> triangles;
+  GLsizei nedges, ntriangles;
+};
+
+#endif // RENDERER_H
@@ -1,8 +1,18 @@
 #ifndef SCHEME_H
 #define SCHEME_H
 
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <vector>
 #include <animal/integration/explicit_solver.h>
+#include <animal/support/profiler.h>
+#include <animal/support/perf_counters.h>
+#include <animal/support/reduction.h>
+#include <animal/support/task_scheduler.h>
+#include <animal/geometry/partition.h>
+#include "contact.h"
 #include "force.h"
 #include "particle.h"
 
@@ -14,6 +24,263 @@ struct Particle_Traits :
 		   std::vector<Particle_Model> >
 {};
 
+#if VOLINFO
+// Volume and energies gathered during the force pass,
+// one partial sum per worker (see volumeInfo())
+struct Volume_Info
+{
+  Real_Acc volume;  // of the tetrahedra
+  Real_Acc elastic; // stretch energy of the springs
+  Real_Acc kinetic; // of the particles
+  
+  Volume_Info() : volume(0.0), elastic(0.0), kinetic(0.0)
+    {}
+  Volume_Info& operator+=(const Volume_Info& v)
+    {
+      volume += v.volume; elastic += v.elastic; kinetic += v.kinetic;
+      return *this;
+    }
+};
+
+typedef animal::support::Reduction<Volume_Info> Volume_Reduction;
+
+// Cleared by each Stoermer_Derivative call, read after the step
+inline Volume_Reduction& volumeInfo()
+{
+  static Volume_Reduction reduction;
+  return reduction;
+}
+#endif
+
+// Called by Stoermer_Derivative between the element and the particle
+// passes, e.g. to complete the forces of particles shared with other
+// processes (see domain.h)
+struct Force_Exchange
+{
+  virtual void operator()(Particle_Traits::Model_t& M) = 0;
+  virtual ~Force_Exchange()
+    {}
+};
+
+// Elements of several types, e.g. tetrahedra and surface springs, each
+// in its own container: a list of containers, Tail being another
+// Element_Tuple or No_Elements. The element passes below are overloaded
+// for it, so that every container is run by its own loop, without
+// virtual calls or tests on the type of each element.
+struct No_Elements
+{};
+
+template <class Head, class Tail = No_Elements>
+struct Element_Tuple
+{
+  Head head;
+  Tail tail;
+  std::vector<std::size_t> head_chunks; // start of each chunk in head (see sortElements())
+  
+  Element_Tuple()
+    {}
+  Element_Tuple(const Head& h, const Tail& t = Tail()) : head(h), tail(t)
+    {}
+};
+
+template <class A, class B>
+Element_Tuple< A, Element_Tuple<B> >
+elementTuple(const A& a, const B& b)
+{
+  return Element_Tuple< A, Element_Tuple<B> >( a, Element_Tuple<B>(b) );
+}
+
+template <class A, class B, class C>
+Element_Tuple< A, Element_Tuple< B, Element_Tuple<C> > >
+elementTuple(const A& a, const B& b, const C& c)
+{
+  return Element_Tuple< A, Element_Tuple< B, Element_Tuple<C> > >( a, elementTuple(b, c) );
+}
+
+// Element passes, on a container of elements F (with random access
+// iterators) or an Element_Tuple of containers
+
+// Number of elements
+template <class C>
+std::size_t elementCount(const C& F)
+{
+  return F.size();
+}
+
+// Name of their type, e.g. for the performance counters
+template <class C>
+const char* elementName(const C&)
+{
+  return C::value_type::name();
+}
+
+// Elements [first, last) of F
+template <class C>
+void elementForces(C& F, Particle_Traits::Model_t& M, const Particle_Traits::State_t& S,
+		   std::size_t first, std::size_t last)
+{
+  typename C::iterator first_F = F.begin() + first;
+  typename C::iterator last_F  = F.begin() + last;
+  
+  for ( ;
+	first_F != last_F;
+	++first_F
+      )
+    {
+      (*first_F)(M, S);
+    }
+}
+
+// All the elements, counted in the region of their type
+template <class C>
+void elementForces(C& F, Particle_Traits::Model_t& M, const Particle_Traits::State_t& S)
+{
+  if ( F.size() == 0 ) return;
+  
+  ANIMAL_PERF_SCOPE(elementName(F), "element", F.size());
+  
+  elementForces(F, M, S, 0, F.size());
+}
+
+// Elements of chunk c (see sortElements())
+template <class C>
+void chunkForces(C& F, const std::vector<std::size_t>& chunks, std::size_t c,
+		 Particle_Traits::Model_t& M, const Particle_Traits::State_t& S)
+{
+  elementForces(F, M, S, chunks[c], chunks[c + 1]);
+}
+
+// Add the elements to partition p, in order
+template <class C>
+void addElements(animal::geometry::Partition& p, const C& F)
+{
+  typedef typename C::value_type Element;
+  
+  for (std::size_t e = 0; e < F.size(); ++e)
+    {
+      animal::geometry::Partition::Index v[Element::NPARTICLES];
+      for (int i = 0; i < Element::NPARTICLES; ++i)
+	v[i] = F[e].particle(i);
+      p.addElement(Element::NPARTICLES, v);
+    }
+}
+
+// Sort F by the ranks of its elements, rank[offset + e] for element e
+// (offset being the number of elements added before F), and set the
+// start of each chunk of F, chunk c holding the elements of ranks in
+// [bounds[c], bounds[c+1])
+template <class C>
+void sortElements(C& F, const std::vector<std::size_t>& rank, std::size_t offset,
+		  const std::vector<std::size_t>& bounds, std::vector<std::size_t>& chunks)
+{
+  std::vector< std::pair<std::size_t, std::size_t> > order( F.size() );
+  for (std::size_t e = 0; e < F.size(); ++e)
+    order[e] = std::make_pair(rank[offset + e], e);
+  std::sort(order.begin(), order.end());
+  
+  C sorted;
+  sorted.reserve( F.size() );
+  for (std::size_t k = 0; k < F.size(); ++k)
+    sorted.push_back( F[ order[k].second ] );
+  F.swap(sorted);
+  
+  chunks.resize( bounds.size() );
+  for (std::size_t c = 0, k = 0; c < bounds.size(); ++c)
+    {
+      while ( k < order.size() && order[k].first < bounds[c] ) ++k;
+      chunks[c] = k;
+    }
+}
+
+// Place the chunks [blocks[w], blocks[w+1]) of F on the node of worker w
+template <class C>
+void placeElements(animal::support::Thread_Pool& pool, C& F,
+		   const std::vector<std::size_t>& chunks, const std::vector<std::size_t>& blocks)
+{
+  std::vector<std::size_t> bounds( blocks.size() );
+  for (std::size_t w = 0; w < blocks.size(); ++w)
+    bounds[w] = chunks[ blocks[w] ];
+  
+  pool.place(F, bounds);
+}
+
+// End of an Element_Tuple
+inline std::size_t elementCount(const No_Elements&) { return 0; }
+inline void elementForces(No_Elements&, Particle_Traits::Model_t&, const Particle_Traits::State_t&)
+{}
+inline void chunkForces(No_Elements&, const std::vector<std::size_t>&, std::size_t,
+			Particle_Traits::Model_t&, const Particle_Traits::State_t&)
+{}
+inline void addElements(animal::geometry::Partition&, const No_Elements&)
+{}
+inline void sortElements(No_Elements&, const std::vector<std::size_t>&, std::size_t,
+			 const std::vector<std::size_t>&, std::vector<std::size_t>&)
+{}
+inline void placeElements(animal::support::Thread_Pool&, No_Elements&,
+			  const std::vector<std::size_t>&, const std::vector<std::size_t>&)
+{}
+
+// Element_Tuple: each container in turn, with the chunks of its own
+template <class H, class T>
+std::size_t elementCount(const Element_Tuple<H, T>& F)
+{
+  return elementCount(F.head) + elementCount(F.tail);
+}
+
+// Name of the only type with elements, if any
+template <class H>
+const char* elementName(const Element_Tuple<H>& F)
+{
+  return elementName(F.head);
+}
+
+template <class H, class T>
+const char* elementName(const Element_Tuple<H, T>& F)
+{
+  if ( elementCount(F.tail) == 0 ) return elementName(F.head);
+  if ( elementCount(F.head) == 0 ) return elementName(F.tail);
+  return "mixed elements";
+}
+
+template <class H, class T>
+void elementForces(Element_Tuple<H, T>& F,
+		   Particle_Traits::Model_t& M, const Particle_Traits::State_t& S)
+{
+  elementForces(F.head, M, S);
+  elementForces(F.tail, M, S);
+}
+
+template <class H, class T>
+void chunkForces(Element_Tuple<H, T>& F, const std::vector<std::size_t>& chunks, std::size_t c,
+		 Particle_Traits::Model_t& M, const Particle_Traits::State_t& S)
+{
+  chunkForces(F.head, F.head_chunks, c, M, S);
+  chunkForces(F.tail, chunks, c, M, S);
+}
+
+template <class H, class T>
+void addElements(animal::geometry::Partition& p, const Element_Tuple<H, T>& F)
+{
+  addElements(p, F.head);
+  addElements(p, F.tail);
+}
+
+template <class H, class T>
+void sortElements(Element_Tuple<H, T>& F, const std::vector<std::size_t>& rank, std::size_t offset,
+		  const std::vector<std::size_t>& bounds, std::vector<std::size_t>& chunks)
+{
+  sortElements(F.head, rank, offset, bounds, F.head_chunks);
+  sortElements(F.tail, rank, offset + elementCount(F.head), bounds, chunks);
+}
+
+template <class H, class T>
+void placeElements(animal::support::Thread_Pool& pool, Element_Tuple<H, T>& F,
+		   const std::vector<std::size_t>& chunks, const std::vector<std::size_t>& blocks)
+{
+  placeElements(pool, F.head, F.head_chunks, blocks);
+  placeElements(pool, F.tail, chunks, blocks);
+}
+
 // Notice : avoid putting restrictions like "const" in function signatures...
 // No one knows what is really useful!
 
@@ -22,36 +289,105 @@ struct Stoermer_Derivative :
   public animal::integration::Derivative_Function<Particle_Traits>
 {
   ForceF_Container F;
+  Force_Exchange* exchange; // 0 for none
+  Contact* contact;         // penalty forces of the obstacles, 0 for none
+  
+  // Parallel passes (see parallelize()), scheduler 0 for the serial ones
+  animal::support::Task_Scheduler* scheduler;
+  std::vector<std::size_t> chunk_first;      // of each element chunk, in breadth first order
+  std::vector<std::size_t> element_chunks;   // of each one in F (see sortElements())
+  std::vector<std::size_t> phase_bounds[2];  // even or odd chunks first given to worker w
+  std::size_t particle_grain;                // particles per chunk of the particle pass
+  std::vector<std::size_t> particle_bounds;  // their chunks first given to worker w
   
-  Stoermer_Derivative() : F()
+  Stoermer_Derivative() : F(), exchange(0), contact(0), scheduler(0), particle_grain(0)
     {}
-  Stoermer_Derivative(const ForceF_Container& ffc) : F(ffc)
+  Stoermer_Derivative(const ForceF_Container& ffc, Force_Exchange* fe = 0)
+    : F(ffc), exchange(fe), contact(0), scheduler(0), particle_grain(0)
     {}
   
-  void operator()(Model_t& M,
-		  const State_t& S,
-		  Derivative_t& D,
-		  const Real_t t)
+  // Run the passes on the workers of s, for n particles. The elements
+  // are taken in the breadth first order of animal::geometry::Partition
+  // and cut into chunks of whole levels: chunks two apart share no
+  // particle, so that even chunks, then odd ones, are run in any order by
+  // any worker (work stealing, elements of very different costs balancing
+  // out). F is sorted in this order (each container of an Element_Tuple
+  // on its own). Chunks are first given to the workers in consecutive
+  // blocks, consecutive workers being on the same NUMA node as far as
+  // possible, and the elements of each block are placed on the node of
+  // its worker. Particles are cut into chunks of equal sizes the same way.
+  void parallelize(animal::support::Task_Scheduler& s, std::size_t n)
     {
-      typename ForceF_Container::iterator first_F = F.begin();
-      typename ForceF_Container::iterator last_F  = F.end();
+      typedef animal::geometry::Partition::Index Index;
       
-      for ( ;
-	    first_F != last_F;
-	    ++first_F
-	  )
+      const std::size_t nw = s.size();
+      const std::size_t ne = elementCount(F);
+      
+      animal::geometry::Partition partition;
+      addElements(partition, F);
+      partition.split(1);
+      
+      // Whole levels, some chunks per worker and phase
+      const std::vector<Index>& levels = partition.levels();
+      const std::size_t grain = std::max<std::size_t>(ne/(8*nw), 64);
+      
+      chunk_first.assign(1, 0);
+      for (std::size_t l = 1; l < levels.size(); ++l)
+	if ( levels[l] - chunk_first.back() >= grain || l + 1 == levels.size() )
+	  chunk_first.push_back( levels[l] );
+      
+      const std::size_t nc = chunk_first.size() - 1;
+      
+      std::vector<std::size_t> rank(ne);
+      for (std::size_t k = 0; k < ne; ++k)
+	rank[ partition.order()[k] ] = k;
+      
+      sortElements(F, rank, 0, chunk_first, element_chunks);
+      
+      // Blocks of nearly equal numbers of elements
+      std::vector<std::size_t> blocks(nw + 1, nc);
+      for (std::size_t w = 0, c = 0; w < nw; ++w)
+	{
+	  while ( c < nc && chunk_first[c] < ne*w/nw ) ++c;
+	  blocks[w] = c;
+	}
+      
+      // Chunk 2k + p is chunk k of phase p
+      for (int p = 0; p < 2; ++p)
 	{
-	  (*first_F)(M, S);
+	  phase_bounds[p].resize(nw + 1);
+	  for (std::size_t w = 0; w <= nw; ++w)
+	    phase_bounds[p][w] = blocks[w] < std::size_t(p) ? 0 : (blocks[w] - p + 1)/2;
 	}
       
-      const Real kd = 5.0e-03;      // coefficient of drag
-      const Vec3 g(0.0, -9.8, 0.0); // gravitational constant
-      const Vec3 p(0.0, -1.0, 0.0); // push force -1.0 for m-s systems, -1.5 elsewhere
+      particle_grain = std::max<std::size_t>(n/(8*nw), 1024);
+      particle_bounds = s.pool().split( (n + particle_grain - 1)/particle_grain );
+      
+      scheduler = &s;
+      placeElements(scheduler->pool(), F, element_chunks, blocks);
+    }
+  
+  // Particles of worker w as placed by parallelize()
+  std::vector<std::size_t> particleRanges(std::size_t n) const
+    {
+      std::vector<std::size_t> bounds( particle_bounds.size() );
+      for (std::size_t w = 0; w < bounds.size(); ++w)
+	bounds[w] = std::min(particle_bounds[w]*particle_grain, n);
+      return bounds;
+    }
+  
+  // Accelerations of particles [first, last)
+  void particlePass(Model_t& M, const State_t& S, Derivative_t& D,
+		    std::size_t first, std::size_t last)
+    {
+      const Real_Acc kd = 5.0e-03;      // coefficient of drag
+      const Vec3_Acc g(0.0, -9.8, 0.0); // gravitational constant
+      const Vec3_Acc p(0.0, -1.0, 0.0); // push force -1.0 for m-s systems, -1.5 elsewhere
       
-      Model_t::iterator       first_M = M.begin();
-      State_t::const_iterator first_S = S.begin();
-      State_t::const_iterator last_S  = S.end();
-      Derivative_t::iterator  first_D = D.begin();
+      Model_t::iterator       first_M = M.begin() + first;
+      State_t::const_iterator first_S = S.begin() + first;
+      State_t::const_iterator last_S  = S.begin() + last;
+      Derivative_t::iterator  first_D = D.begin() + first;
       
       for ( ;
 	    first_S != last_S;
@@ -60,57 +396,152 @@ struct Stoermer_Derivative :
 	{
 	  Particle_State::constraint_mode cst = (*first_S).constraint;
 	  
+#if VOLINFO
+	  volumeInfo().local().kinetic += 0.5 * (*first_M).m * (*first_S).vel.sqnorm();
+#endif
+	  
 	  if ( cst == Particle_State::NO_CONSTRAINT
 #if MEASURE
 	       || cst == Particle_State::OBSERVED
 #endif
 	     )
 	    {
-#if MEASURE
-	      if ( cst == Particle_State::OBSERVED )
-	        {
-		  cout << (*first_S).pos << endl;
-	        }
-#endif
-	      Vec3 force = (*first_M).f;
-	      Real mass  = (*first_M).m;
+	      Vec3_Acc force = (*first_M).f;
+	      Real_Acc mass  = (*first_M).m;
 	      
-	      force += - kd * (*first_S).vel; // viscous drag
-	      force += mass * g;              // gravitational force
+	      force += - kd * Vec3_Acc( (*first_S).vel ); // viscous drag
+	      force += mass * g;                          // gravitational force
 	      
-	      (*first_D).acc = force/mass;
-	      (*first_M).f = Vec3::null();    // clear force
+	      if ( contact )
+		contact->force(first_S - S.begin(), *first_S, force);
+	      
+	      (*first_D).acc = Vec3( force/mass );
+	      (*first_M).f = Vec3_Acc::null(); // clear force
 	    }
 	  else if ( cst == Particle_State::PUSHED )
 	    {
-	      Vec3 force = (*first_M).f;
-	      Real mass  = (*first_M).m;
+	      Vec3_Acc force = (*first_M).f;
+	      Real_Acc mass  = (*first_M).m;
+	      
+	      force += - kd * Vec3_Acc( (*first_S).vel ); // viscous drag
+	      force += mass * g;                          // gravitational force
+	      force += p;                                 // push
 	      
-	      force += - kd * (*first_S).vel; // viscous drag
-	      force += mass * g;              // gravitational force
-	      force += p;                     // push
+	      if ( contact )
+		contact->force(first_S - S.begin(), *first_S, force);
 	      
-	      (*first_D).acc = force/mass;
-	      (*first_M).f = Vec3::null();    // clear force
+	      (*first_D).acc = Vec3( force/mass );
+	      (*first_M).f = Vec3_Acc::null(); // clear force
 	    }
 	}
     }
+  
+  // Chunk c of a phase: element chunk 2c + phase, or particle chunk c
+  // for phase 2
+  struct Pass : public animal::support::Chunk_Task
+  {
+    Stoermer_Derivative* d;
+    Model_t* M;
+    const State_t* S;
+    Derivative_t* D;
+    int phase;
+    
+    void operator()(std::size_t c, int)
+      {
+	if ( phase == 2 )
+	  {
+	    std::size_t first = c*d->particle_grain;
+	    d->particlePass(*M, *S, *D, first, std::min(first + d->particle_grain, S->size()));
+	    return;
+	  }
+	
+	chunkForces(d->F, d->element_chunks, 2*c + phase, *M, *S);
+      }
+  };
+  
+  void operator()(Model_t& M,
+		  const State_t& S,
+		  Derivative_t& D,
+		  const Real_t t)
+    {
+      ANIMAL_PROFILE_SCOPE("derivative");
+      
+#if VOLINFO
+      volumeInfo().clear();
+#endif
+      
+      Pass pass;
+      pass.d = this;
+      pass.M = &M;
+      pass.S = &S;
+      pass.D = &D;
+      
+      {
+	ANIMAL_PROFILE_SCOPE("force");
+	
+	if ( scheduler )
+	  {
+	    // Chunks hold elements of every type: one region for all
+	    animal::support::Perf_Scope
+	      scope( animal::support::Perf_Counters::instance().region(elementName(F), "element"),
+		     elementCount(F) );
+	    
+	    for (pass.phase = 0; pass.phase < 2; ++pass.phase)
+	      scheduler->run(pass, phase_bounds[pass.phase]);
+	  }
+	else
+	  elementForces(F, M, S); // one region per type
+      }
+      
+      if ( exchange )
+	(*exchange)(M);
+      
+      ANIMAL_PERF_SCOPE("particle pass", "particle", S.size());
+      
+      if ( scheduler )
+	{
+	  pass.phase = 2;
+	  scheduler->run(pass, particle_bounds);
+	}
+      else
+	particlePass(M, S, D, 0, S.size());
+    }
 };
 
 struct Stoermer_Step :
   public animal::integration::Step_Function<Particle_Traits>
 {
-  void operator()(const State_t& initial_S,
-		  State_t& final_S,
-		  const Derivative_t& D,
-		  const Real_t h) const // should contain Model_t too
+  // Parallel step (see parallelize()), scheduler 0 for the serial one
+  animal::support::Task_Scheduler* scheduler;
+  std::size_t particle_grain;               // particles per chunk
+  std::vector<std::size_t> particle_bounds; // chunks first given to worker w
+  
+  Contact* contact; // projection out of the obstacles, 0 for none
+  
+  Stoermer_Step() : scheduler(0), particle_grain(0), contact(0)
+    {}
+  
+  // Run the step on the workers of s, for n particles in chunks of
+  // grain particles first given to the workers as bounds
+  void parallelize(animal::support::Task_Scheduler& s, std::size_t grain,
+		   const std::vector<std::size_t>& bounds)
     {
-      Real_t sqh = h*h;
-      
-      State_t::const_iterator      first_iS = initial_S.begin();
-      State_t::const_iterator      last_iS  = initial_S.end();
-      State_t::iterator            first_fS = final_S.begin();
-      Derivative_t::const_iterator first_D  = D.begin();
+      scheduler = &s;
+      particle_grain = grain;
+      particle_bounds = bounds;
+    }
+  
+  // Particles [first, last)
+  void step(const State_t& initial_S,
+	    State_t& final_S,
+	    const Derivative_t& D,
+	    const Real sqh,
+	    std::size_t first, std::size_t last) const
+    {
+      State_t::const_iterator      first_iS = initial_S.begin() + first;
+      State_t::const_iterator      last_iS  = initial_S.begin() + last;
+      State_t::iterator            first_fS = final_S.begin() + first;
+      Derivative_t::const_iterator first_D  = D.begin() + first;
       
       for ( ;
 	    first_iS != last_iS;
@@ -128,12 +559,133 @@ struct Stoermer_Step :
 	    {
 	      (*first_fS).vel = (*first_iS).vel + sqh*(*first_D).acc;
 	      (*first_fS).pos = (*first_iS).pos + (*first_fS).vel;
+	      
+	      if ( contact )
+		contact->project(first_iS - initial_S.begin(), *first_fS);
 	    }
 	}
     }
+  
+  struct Pass : public animal::support::Chunk_Task
+  {
+    const Stoermer_Step* s;
+    const State_t* initial_S;
+    State_t* final_S;
+    const Derivative_t* D;
+    Real sqh;
+    
+    void operator()(std::size_t c, int)
+      {
+	std::size_t first = c*s->particle_grain;
+	s->step(*initial_S, *final_S, *D, sqh,
+		first, std::min(first + s->particle_grain, initial_S->size()));
+      }
+  };
+  
+  void operator()(const State_t& initial_S,
+		  State_t& final_S,
+		  const Derivative_t& D,
+		  const Real_t h) const // should contain Model_t too
+    {
+      ANIMAL_PROFILE_SCOPE("step");
+      ANIMAL_PERF_SCOPE("step", "particle", initial_S.size());
+      
+      Real sqh = h*h; // in the precision of the state
+      
+      if ( scheduler )
+	{
+	  Pass pass;
+	  pass.s = this;
+	  pass.initial_S = &initial_S;
+	  pass.final_S = &final_S;
+	  pass.D = &D;
+	  pass.sqh = sqh;
+	  
+	  scheduler->run(pass, particle_bounds);
+	}
+      else
+	step(initial_S, final_S, D, sqh, 0, initial_S.size());
+    }
 };
 
-struct Spring : public Force_Function<Particle_Traits>
+// Performance counters of every worker (see Perf_Counters::attach())
+struct Attach_Counters : public animal::support::Thread_Task
+{
+  void operator()(int)
+    {
+      animal::support::Perf_Counters::instance().attach();
+    }
+};
+
+// Run the passes of the solver of drive on the workers of scheduler (see
+// Stoermer_Derivative::parallelize()), and place the model, state and
+// derivative of the particle chunks of each worker on its node
+template <class DriverT>
+void parallelize(animal::support::Task_Scheduler& scheduler, DriverT& drive,
+		 Particle_Traits::Model_t& M, Particle_Traits::State_t& S)
+{
+  if ( animal::support::Perf_Counters::instance().enabled() )
+    {
+      Attach_Counters attach;
+      scheduler.pool().run(attach);
+    }
+  
+  drive.compute.writeDerivative.parallelize(scheduler, S.size());
+  drive.compute.applyStep.parallelize(scheduler,
+				      drive.compute.writeDerivative.particle_grain,
+				      drive.compute.writeDerivative.particle_bounds);
+  
+  std::vector<std::size_t> bounds = drive.compute.writeDerivative.particleRanges( S.size() );
+  scheduler.pool().place(M, bounds);
+  scheduler.pool().place(S, bounds);
+  scheduler.pool().place(drive.compute.D, bounds);
+}
+
+// Positions and velocities (in m/s, h being the time step) of the
+// particles, 6 values each from v, as recorded in trajectories: on the
+// particle chunks of derivative d when parallel, like the other passes
+template <class DerivativeT>
+void copyFrame(const DerivativeT& d, const Particle_Traits::State_t& S, double h, double* v)
+{
+  struct Copy : public animal::support::Chunk_Task
+  {
+    const Particle_Traits::State_t* S;
+    double h_inv;
+    double* v;
+    std::size_t grain;
+    
+    void operator()(std::size_t c, int)
+      {
+	std::size_t last = std::min( (c + 1)*grain, S->size() );
+	
+	for (std::size_t i = c*grain; i < last; ++i)
+	  {
+	    const Particle_State& s = (*S)[i];
+	    double* x = v + 6*i;
+	    
+	    x[0] = s.pos[0]; x[1] = s.pos[1]; x[2] = s.pos[2];
+	    x[3] = h_inv*s.vel[0]; x[4] = h_inv*s.vel[1]; x[5] = h_inv*s.vel[2];
+	  }
+      }
+  } copy;
+  
+  copy.S = &S;
+  copy.h_inv = 1.0/h;
+  copy.v = v;
+  
+  if ( d.scheduler )
+    {
+      copy.grain = d.particle_grain;
+      d.scheduler->run(copy, d.particle_bounds);
+    }
+  else
+    {
+      copy.grain = S.size();
+      copy(0, 0);
+    }
+}
+
+struct Spring : public Force_Function<Particle_Traits, Real>
 {
   State_t::size_type p0, p1; // indices
   
@@ -144,6 +696,16 @@ struct Spring : public Force_Function<Particle_Traits>
   Real_t kd; // damping constant
 #endif
   
+  static const char* name() { return "Spring"; }
+  
+  // Particles, e.g. to partition the elements (see domain.h)
+  enum { NPARTICLES = 2 };
+  unsigned int particle(int i) const { return i ? p1 : p0; }
+  void renumber(const std::vector<unsigned int>& map)
+    {
+      p0 = map[p0]; p1 = map[p1];
+    }
+  
   Spring()
     {}
   Spring(const State_t::size_type i0, const State_t::size_type i1,
@@ -173,31 +735,119 @@ struct Spring : public Force_Function<Particle_Traits>
       Vec3_t F = - ( ks*(L - L0) ) * nl;
 #endif
       
-      M[p0].f +=   F;
-      M[p1].f += - F;
+      M[p0].f += Vec3_Acc( F );
+      M[p1].f += Vec3_Acc( - F );
+      
+#if VOLINFO
+      volumeInfo().local().elastic += 0.5*ks*(L - L0)*(L - L0);
+#endif
     }
 };
 
-struct TetraSpring : public Force_Function<Particle_Traits>
+// Stiffness and damping constants of the fiber elements. They are
+// the same for all the elements of a material: elements keep the
+// index of their constants in a table of the distinct values, which
+// is filled while building the elements (not thread-safe) and read
+// during the force pass.
+struct Fiber_Params
 {
-  State_t::size_type p0, p1, p2, p3; // particles indices
-  Vec3_t f1, ff1, f2, ff2, f3, ff3;  // intersection points
+  Real ks1, ks2, ks3; // fiber stiffness
+  Real ks4, ks5, ks6; // angle stiffness (12, 13, 23)
+  Real kd1, kd2, kd3; // fiber damping
+  Real ks, kd;        // volume stiffness and damping
   
-  int vi[6][3];    // vertices indices
-  Real_t cf[6][3]; // interpolation coefs
+  bool operator==(const Fiber_Params& p) const
+    {
+      return ks1 == p.ks1 && ks2 == p.ks2 && ks3 == p.ks3 &&
+	     ks4 == p.ks4 && ks5 == p.ks5 && ks6 == p.ks6 &&
+	     kd1 == p.kd1 && kd2 == p.kd2 && kd3 == p.kd3 &&
+	     ks == p.ks && kd == p.kd;
+    }
   
-  Real_t ks1, ks2, ks3, ks4, ks5, ks6; // stiffness constant
-  Real_t L01, L02, L03;                // rest length
+  // Index of p in the table, added if new
+  static unsigned short add(const Fiber_Params& p)
+    {
+      std::vector<Fiber_Params>& t = table();
+      
+      for (std::vector<Fiber_Params>::size_type i = 0; i < t.size(); ++i)
+	if ( t[i] == p ) return i;
+      
+      if ( t.size() > USHRT_MAX )
+	{
+	  std::fprintf(stderr, "Fiber_Params: more than %d distinct constants\n",
+		       USHRT_MAX + 1);
+	  std::exit(1);
+	}
+      
+      t.push_back(p);
+      return t.size() - 1;
+    }
   
-#if DAMPED
-  Real_t kd1, kd2, kd3;                // damping constant
-#endif
+  static const Fiber_Params& get(unsigned short i)
+    {
+      const std::vector<Fiber_Params>* t = bound();
+      return t ? (*t)[i] : table()[i];
+    }
+  
+  // All the constants, indexed as above (saved with the elements
+  // by checkpoints)
+  static std::vector<Fiber_Params>& table()
+    {
+      static std::vector<Fiber_Params> t;
+      return t;
+    }
+  
+  // Another table, same indices, read by get() on the calling thread
+  // instead of table(); 0 to read table() again. Lets the members of
+  // an ensemble share the elements with their own constants (see
+  // ensemble.h).
+  static void use(const std::vector<Fiber_Params>* t) { bound() = t; }
+  
+  static const std::vector<Fiber_Params>*& bound()
+    {
+      static __thread const std::vector<Fiber_Params>* t = 0;
+      return t;
+    }
+};
+
+// Fiber end points of an element, unpacked from the element storage
+// once per evaluation: face vertices and their weights, for N-vertex
+// faces (3 for tetrahedra, 4 for hexahedra)
+template <int N>
+struct Fiber_Points
+{
+  int v[6][N];  // vertices of the face of point i
+  Real k[6][N]; // their weights
+};
+
+struct TetraSpring : public Force_Function<Particle_Traits, Real>
+{
+  unsigned int p0, p1, p2, p3; // particles indices
+  
+  unsigned char vi[6];  // vertices of point i, 2 bits each (see unpack())
+  unsigned short params; // constants (see Fiber_Params)
+  float cf[6][2];        // interpolation coefs, the third is 1 - cf0 - cf1
+  
+  Real_t L01, L02, L03; // rest length
   
 #if CONSTVOL
-  Real_t ks; // volume stiffness
   Real_t L0; // volume rest length
 #endif
   
+  static const char* name() { return "TetraSpring"; }
+  
+  // Particles, e.g. to partition the elements (see domain.h)
+  enum { NPARTICLES = 4 };
+  unsigned int particle(int i) const
+    {
+      const unsigned int p[4] = { p0, p1, p2, p3 };
+      return p[i];
+    }
+  void renumber(const std::vector<unsigned int>& map)
+    {
+      p0 = map[p0]; p1 = map[p1]; p2 = map[p2]; p3 = map[p3];
+    }
+  
   TetraSpring()
     {}
   TetraSpring(const State_t::size_type i0, const State_t::size_type i1,
@@ -212,47 +862,79 @@ struct TetraSpring : public Force_Function<Particle_Traits>
     {
       p0 = i0; p1 = i1; p2 = i2; p3 = i3;
       
-      f1  = ip1; ff1 = ip2; f2  = ip3;
-      ff2 = ip4; f3  = ip5; ff3 = ip6;
-      
       for (int i = 0; i < 6; ++i)
-	for (int j = 0; j < 3; ++j)
-	  {
-	    vi[i][j] = tabv[i][j];
-	    cf[i][j] = tabc[i][j];
-	  }
-      
-      ks1 = s1; ks2 = s2; ks3 = s3;
-      ks4 = s4; ks5 = s5; ks6 = s6;
+	{
+	  vi[i] = tabv[i][0] | tabv[i][1] << 2 | tabv[i][2] << 4;
+	  cf[i][0] = tabc[i][0];
+	  cf[i][1] = tabc[i][1];
+	}
       
-#if DAMPED
-      kd1 = d1; kd2 = d2; kd3 = d3;
-#endif
+      Fiber_Params k = { s1, s2, s3, s4, s5, s6, d1, d2, d3, s, 0.0 };
+      params = Fiber_Params::add(k);
       
-      Vec3_t l1 = f1 - ff1;
-      Vec3_t l2 = f2 - ff2;
-      Vec3_t l3 = f3 - ff3;
+      Vec3_t l1 = ip1 - ip2;
+      Vec3_t l2 = ip3 - ip4;
+      Vec3_t l3 = ip5 - ip6;
       
       L01 = l1.norm();
       L02 = l2.norm();
       L03 = l3.norm();
       
 #if CONSTVOL
-      ks = s;
       L0 = rl;
 #endif
     }
   
-  void operator()(Model_t& M, const State_t& S)
+  // Vertices, and barycentric weights
+  void unpack(Fiber_Points<3>& P) const
+    {
+      for (int i = 0; i < 6; ++i)
+	{
+	  P.v[i][0] = vi[i] & 3;
+	  P.v[i][1] = vi[i] >> 2 & 3;
+	  P.v[i][2] = vi[i] >> 4 & 3;
+	  
+	  P.k[i][0] = cf[i][0];
+	  P.k[i][1] = cf[i][1];
+	  P.k[i][2] = Real_t(1.0) - cf[i][0] - cf[i][1];
+	}
+    }
+  
+  // Point i of the fibers (f1, ff1, f2, ff2, f3, ff3), interpolated
+  // from the element vertices x (positions or velocities)
+  static Vec3_t point(const Fiber_Points<3>& P, const Vec3_t x[4], int i)
+    {
+      return lincomb(3, P.k[i], x, P.v[i]);
+    }
+  
+  // End points of fiber axis (0, 1 or 2), for display only: computed
+  // on demand, the force pass does not store them
+  void fiber(const State_t& S, int axis, Vec3_t& f, Vec3_t& ff) const
+    {
+      Vec3_t pos[4] = { S[p0].pos, S[p1].pos, S[p2].pos, S[p3].pos };
+      
+      Fiber_Points<3> P;
+      unpack(P);
+      
+      f  = point(P, pos, 2*axis);
+      ff = point(P, pos, 2*axis + 1);
+    }
+  
+  void operator()(Model_t& M, const State_t& S) const
     {
+      const Fiber_Params& k = Fiber_Params::get(params);
+      
+      Fiber_Points<3> P;
+      unpack(P);
+      
       Vec3_t pos[4] = { S[p0].pos, S[p1].pos, S[p2].pos, S[p3].pos };
       
-      f1  = cf[0][0] * pos[vi[0][0]] + cf[0][1] * pos[vi[0][1]] + cf[0][2] * pos[vi[0][2]];
-      ff1 = cf[1][0] * pos[vi[1][0]] + cf[1][1] * pos[vi[1][1]] + cf[1][2] * pos[vi[1][2]];
-      f2  = cf[2][0] * pos[vi[2][0]] + cf[2][1] * pos[vi[2][1]] + cf[2][2] * pos[vi[2][2]];
-      ff2 = cf[3][0] * pos[vi[3][0]] + cf[3][1] * pos[vi[3][1]] + cf[3][2] * pos[vi[3][2]];
-      f3  = cf[4][0] * pos[vi[4][0]] + cf[4][1] * pos[vi[4][1]] + cf[4][2] * pos[vi[4][2]];
-      ff3 = cf[5][0] * pos[vi[5][0]] + cf[5][1] * pos[vi[5][1]] + cf[5][2] * pos[vi[5][2]];
+      Vec3_t f1  = point(P, pos, 0);
+      Vec3_t ff1 = point(P, pos, 1);
+      Vec3_t f2  = point(P, pos, 2);
+      Vec3_t ff2 = point(P, pos, 3);
+      Vec3_t f3  = point(P, pos, 4);
+      Vec3_t ff3 = point(P, pos, 5);
       
       Vec3_t l1 = f1 - ff1;
       Vec3_t l2 = f2 - ff2;
@@ -269,12 +951,12 @@ struct TetraSpring : public Force_Function<Particle_Traits>
 #if DAMPED
       Vec3_t vel[4] = { S[p0].vel, S[p1].vel, S[p2].vel, S[p3].vel };
       
-      Vec3_t vf1  = cf[0][0] * vel[vi[0][0]] + cf[0][1] * vel[vi[0][1]] + cf[0][2] * vel[vi[0][2]];
-      Vec3_t vff1 = cf[1][0] * vel[vi[1][0]] + cf[1][1] * vel[vi[1][1]] + cf[1][2] * vel[vi[1][2]];
-      Vec3_t vf2  = cf[2][0] * vel[vi[2][0]] + cf[2][1] * vel[vi[2][1]] + cf[2][2] * vel[vi[2][2]];
-      Vec3_t vff2 = cf[3][0] * vel[vi[3][0]] + cf[3][1] * vel[vi[3][1]] + cf[3][2] * vel[vi[3][2]];
-      Vec3_t vf3  = cf[4][0] * vel[vi[4][0]] + cf[4][1] * vel[vi[4][1]] + cf[4][2] * vel[vi[4][2]];
-      Vec3_t vff3 = cf[5][0] * vel[vi[5][0]] + cf[5][1] * vel[vi[5][1]] + cf[5][2] * vel[vi[5][2]];
+      Vec3_t vf1  = point(P, vel, 0);
+      Vec3_t vff1 = point(P, vel, 1);
+      Vec3_t vf2  = point(P, vel, 2);
+      Vec3_t vff2 = point(P, vel, 3);
+      Vec3_t vf3  = point(P, vel, 4);
+      Vec3_t vff3 = point(P, vel, 5);
       
       Vec3_t vl1 = vf1 - vff1;
       Vec3_t vl2 = vf2 - vff2;
@@ -291,18 +973,18 @@ struct TetraSpring : public Force_Function<Particle_Traits>
       Vec3_t nl3 = l3*L3_inv;
       
 #if DAMPED
-      Vec3_t F1 = - ( ks1*(L1 - L01) + kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) + kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) + kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) + k.kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) + k.kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) + k.kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
 #else
-      Vec3_t F1 = - ( ks1*(L1 - L01) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) ) * nl3;
 #endif
       
-      Real K12  = - ( ks4*cosang12 );
-      Real K13  = - ( ks5*cosang13 );
-      Real K23  = - ( ks6*cosang23 );
+      Real K12  = - ( k.ks4*cosang12 );
+      Real K13  = - ( k.ks5*cosang13 );
+      Real K23  = - ( k.ks6*cosang23 );
       
       Vec3_t Ff1  =   F1 + K12*nl2 + K13*nl3;
       Vec3_t Fff1 = - Ff1;
@@ -330,18 +1012,18 @@ struct TetraSpring : public Force_Function<Particle_Traits>
       Vec3_t nl2 = l2*L2_inv;
       Vec3_t nl3 = l3*L3_inv;
       
-      Vec3_t F1 = - ( ks1*(L1 - L01) + kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) + kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) + kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) + k.kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) + k.kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) + k.kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
 #else
-      Vec3_t F1 = - ( ks1*(L1 - L01) ) * (l1*L1_inv);
-      Vec3_t F2 = - ( ks2*(L2 - L02) ) * (l2*L2_inv);
-      Vec3_t F3 = - ( ks3*(L3 - L03) ) * (l3*L3_inv);
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) ) * (l1*L1_inv);
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) ) * (l2*L2_inv);
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) ) * (l3*L3_inv);
 #endif
       
-      Real K12 = ( ks4*cosang12 );
-      Real K13 = ( ks5*cosang13 );
-      Real K23 = ( ks6*cosang23 );
+      Real K12 = ( k.ks4*cosang12 );
+      Real K13 = ( k.ks5*cosang13 );
+      Real K23 = ( k.ks6*cosang23 );
       
       Vec3_t Ff1  =   F1 + K12*n112 + K13*n113;
       Vec3_t Fff1 = - Ff1;
@@ -355,32 +1037,14 @@ struct TetraSpring : public Force_Function<Particle_Traits>
       
       Vec3_t frc[4] = { Vec3_t::null(), Vec3_t::null(), Vec3_t::null(), Vec3_t::null() };
       
-      frc[vi[0][0]] += cf[0][0] * Ff1;
-      frc[vi[0][1]] += cf[0][1] * Ff1;
-      frc[vi[0][2]] += cf[0][2] * Ff1;
-      
-      frc[vi[1][0]] += cf[1][0] * Fff1;
-      frc[vi[1][1]] += cf[1][1] * Fff1;
-      frc[vi[1][2]] += cf[1][2] * Fff1;
-      
-      frc[vi[2][0]] += cf[2][0] * Ff2;
-      frc[vi[2][1]] += cf[2][1] * Ff2;
-      frc[vi[2][2]] += cf[2][2] * Ff2;
+      const Vec3_t* F[6] = { &Ff1, &Fff1, &Ff2, &Fff2, &Ff3, &Fff3 };
       
-      frc[vi[3][0]] += cf[3][0] * Fff2;
-      frc[vi[3][1]] += cf[3][1] * Fff2;
-      frc[vi[3][2]] += cf[3][2] * Fff2;
-      
-      frc[vi[4][0]] += cf[4][0] * Ff3;
-      frc[vi[4][1]] += cf[4][1] * Ff3;
-      frc[vi[4][2]] += cf[4][2] * Ff3;
-      
-      frc[vi[5][0]] += cf[5][0] * Fff3;
-      frc[vi[5][1]] += cf[5][1] * Fff3;
-      frc[vi[5][2]] += cf[5][2] * Fff3;
+      for (int i = 0; i < 6; ++i)
+	for (int j = 0; j < 3; ++j)
+	  frc[ P.v[i][j] ] += P.k[i][j] * (*F[i]);
       
 #if CONSTVOL
-      Vec3_t g_pos = 0.25*(pos[0] + pos[1] + pos[2] + pos[3]);
+      Vec3_t g_pos = Real_t(0.25)*(pos[0] + pos[1] + pos[2] + pos[3]);
       
       Vec3_t d0 = pos[0] - g_pos;
       Vec3_t d1 = pos[1] - g_pos;
@@ -394,48 +1058,73 @@ struct TetraSpring : public Force_Function<Particle_Traits>
       
       Real_t D = D0 + D1 + D2 + D3;
       
-      Real_t K = - ( ks*(D - L0) );
+      Real_t K = - ( k.ks*(D - L0) );
       
-      M[p0].f += frc[0] + K * (d0/D0);
-      M[p1].f += frc[1] + K * (d1/D1);
-      M[p2].f += frc[2] + K * (d2/D2);
-      M[p3].f += frc[3] + K * (d3/D3);
+      M[p0].f += Vec3_Acc( frc[0] + K * (d0/D0) );
+      M[p1].f += Vec3_Acc( frc[1] + K * (d1/D1) );
+      M[p2].f += Vec3_Acc( frc[2] + K * (d2/D2) );
+      M[p3].f += Vec3_Acc( frc[3] + K * (d3/D3) );
 #else
-      M[p0].f += frc[0];
-      M[p1].f += frc[1];
-      M[p2].f += frc[2];
-      M[p3].f += frc[3];
+      M[p0].f += Vec3_Acc( frc[0] );
+      M[p1].f += Vec3_Acc( frc[1] );
+      M[p2].f += Vec3_Acc( frc[2] );
+      M[p3].f += Vec3_Acc( frc[3] );
+#endif
+      
+#if VOLINFO
+      Volume_Info& info = volumeInfo().local();
+      
+      Vec3_t v01 = pos[1] - pos[0];
+      Vec3_t v02 = pos[2] - pos[0];
+      Vec3_t v03 = pos[3] - pos[0];
+      
+      info.volume += 0.16666667 *
+	fabs( animal::geometry::dot( animal::geometry::cross( v01, v02 ), v03 ) );
+      // one-sixth
+      
+      info.elastic += 0.5*( k.ks1*(L1 - L01)*(L1 - L01) +
+			    k.ks2*(L2 - L02)*(L2 - L02) +
+			    k.ks3*(L3 - L03)*(L3 - L03) );
+#if CONSTVOL
+      info.elastic += 0.5*k.ks*(D - L0)*(D - L0);
+#endif
 #endif
     }
 };
 
-struct HexaSpring : public Force_Function<Particle_Traits>
+struct HexaSpring : public Force_Function<Particle_Traits, Real>
 {
-  State_t::size_type p0, p1, p2, p3, p4, p5, p6, p7; // particles indices
-  Vec3_t f1, ff1, f2, ff2, f3, ff3;                  // intersection points
+  unsigned int p0, p1, p2, p3, p4, p5, p6, p7; // particles indices
   
-  int vi[6][4];    // vertices indices
-  Real_t cf[6][4]; // interpolation coefs
+  unsigned short vi[6]; // vertices of point i, 3 bits each (see unpack())
+  unsigned short params; // constants (see Fiber_Params)
+  float cf[6][2];        // interpolation coefs, the others are 1 - cf0, 1 - cf1
   
-  Real_t ks1, ks2, ks3, ks4, ks5, ks6; // stiffness constant
-  Real_t L01, L02, L03;                // rest length
-  
-#if DAMPED
-  Real_t kd1, kd2, kd3;                // damping constant
-#endif
+  float L01, L02, L03; // rest length, float like cf
   
 #if CONSTVOL
-  Real_t ks; // volume stiffness
 #if ALTERN
-  Real_t D00, D01, D02, D03, D04, D05, D06, D07;
-#if DAMPED
-  Real_t kd;
-#endif
+  float D00, D01, D02, D03, D04, D05, D06, D07;
 #else
-  Real_t L0; // volume rest length
+  float L0; // volume rest length
 #endif
 #endif
   
+  static const char* name() { return "HexaSpring"; }
+  
+  // Particles, e.g. to partition the elements (see domain.h)
+  enum { NPARTICLES = 8 };
+  unsigned int particle(int i) const
+    {
+      const unsigned int p[8] = { p0, p1, p2, p3, p4, p5, p6, p7 };
+      return p[i];
+    }
+  void renumber(const std::vector<unsigned int>& map)
+    {
+      p0 = map[p0]; p1 = map[p1]; p2 = map[p2]; p3 = map[p3];
+      p4 = map[p4]; p5 = map[p5]; p6 = map[p6]; p7 = map[p7];
+    }
+  
   HexaSpring()
     {}
   HexaSpring(const State_t::size_type i0, const State_t::size_type i1,
@@ -455,46 +1144,64 @@ struct HexaSpring : public Force_Function<Particle_Traits>
       p0 = i0; p1 = i1; p2 = i2; p3 = i3;
       p4 = i4; p5 = i5; p6 = i6; p7 = i7;
       
-      f1  = ip1; ff1 = ip2; f2  = ip3;
-      ff2 = ip4; f3  = ip5; ff3 = ip6;
-      
       for (int i = 0; i < 6; ++i)
-	for (int j = 0; j < 4; ++j)
-	  {
-	    vi[i][j] = tabv[i][j];
-	    cf[i][j] = tabc[i][j];
-	  }
-      
-      ks1 = s1; ks2 = s2; ks3 = s3;
-      ks4 = s4; ks5 = s5; ks6 = s6;
+	{
+	  vi[i] = tabv[i][0] | tabv[i][1] << 3 | tabv[i][2] << 6 | tabv[i][3] << 9;
+	  cf[i][0] = tabc[i][0];
+	  cf[i][1] = tabc[i][1];
+	}
       
-#if DAMPED      
-      kd1 = d1; kd2 = d2; kd3 = d3;
-#endif
+      Fiber_Params k = { s1, s2, s3, s4, s5, s6, d1, d2, d3, s, d };
+      params = Fiber_Params::add(k);
       
-      Vec3_t l1 = f1 - ff1;
-      Vec3_t l2 = f2 - ff2;
-      Vec3_t l3 = f3 - ff3;
+      Vec3_t l1 = ip1 - ip2;
+      Vec3_t l2 = ip3 - ip4;
+      Vec3_t l3 = ip5 - ip6;
       
       L01 = l1.norm();
       L02 = l2.norm();
       L03 = l3.norm();
       
 #if CONSTVOL
-      ks = s;
 #if ALTERN
       D00 = rl0; D01 = rl1; D02 = rl2; D03 = rl3;
       D04 = rl4; D05 = rl5; D06 = rl6; D07 = rl7;
-#if DAMPED
-      kd = d;
-#endif
 #else
       L0 = rl;
 #endif
 #endif
     }
   
-  void operator()(Model_t& M, const State_t& S)
+  // Vertices, and bilinear weights
+  void unpack(Fiber_Points<4>& P) const
+    {
+      for (int i = 0; i < 6; ++i)
+	{
+	  P.v[i][0] = vi[i] & 7;
+	  P.v[i][1] = vi[i] >> 3 & 7;
+	  P.v[i][2] = vi[i] >> 6 & 7;
+	  P.v[i][3] = vi[i] >> 9 & 7;
+	  
+	  Real_t c0 = cf[i][0], c1 = cf[i][1];
+	  Real_t c2 = Real_t(1.0) - c0, c3 = Real_t(1.0) - c1;
+	  
+	  P.k[i][0] = c0 * c1;
+	  P.k[i][1] = c2 * c1;
+	  P.k[i][2] = c2 * c3;
+	  P.k[i][3] = c0 * c3;
+	}
+    }
+  
+  // Point i of the fibers (f1, ff1, f2, ff2, f3, ff3), interpolated
+  // from the element vertices x (positions or velocities)
+  static Vec3_t point(const Fiber_Points<4>& P, const Vec3_t x[8], int i)
+    {
+      return lincomb(4, P.k[i], x, P.v[i]);
+    }
+  
+  // End points of fiber axis (0, 1 or 2), for display only: computed
+  // on demand, the force pass does not store them
+  void fiber(const State_t& S, int axis, Vec3_t& f, Vec3_t& ff) const
     {
       Vec3_t pos[8] =
         {
@@ -502,35 +1209,32 @@ struct HexaSpring : public Force_Function<Particle_Traits>
 	  S[p4].pos, S[p5].pos, S[p6].pos, S[p7].pos
         };
       
-      f1  = cf[0][0] * cf[0][1] * pos[vi[0][0]] +
-	    cf[0][2] * cf[0][1] * pos[vi[0][1]] +
-	    cf[0][2] * cf[0][3] * pos[vi[0][2]] +
-	    cf[0][0] * cf[0][3] * pos[vi[0][3]];
+      Fiber_Points<4> P;
+      unpack(P);
       
-      ff1 = cf[1][0] * cf[1][1] * pos[vi[1][0]] +
-	    cf[1][2] * cf[1][1] * pos[vi[1][1]] +
-	    cf[1][2] * cf[1][3] * pos[vi[1][2]] +
-	    cf[1][0] * cf[1][3] * pos[vi[1][3]];
-      
-      f2  = cf[2][0] * cf[2][1] * pos[vi[2][0]] +
-	    cf[2][2] * cf[2][1] * pos[vi[2][1]] +
-	    cf[2][2] * cf[2][3] * pos[vi[2][2]] +
-	    cf[2][0] * cf[2][3] * pos[vi[2][3]];
+      f  = point(P, pos, 2*axis);
+      ff = point(P, pos, 2*axis + 1);
+    }
+  
+  void operator()(Model_t& M, const State_t& S) const
+    {
+      const Fiber_Params& k = Fiber_Params::get(params);
       
-      ff2 = cf[3][0] * cf[3][1] * pos[vi[3][0]] +
-	    cf[3][2] * cf[3][1] * pos[vi[3][1]] +
-	    cf[3][2] * cf[3][3] * pos[vi[3][2]] +
-	    cf[3][0] * cf[3][3] * pos[vi[3][3]];
+      Fiber_Points<4> P;
+      unpack(P);
       
-      f3  = cf[4][0] * cf[4][1] * pos[vi[4][0]] +
-	    cf[4][2] * cf[4][1] * pos[vi[4][1]] +
-	    cf[4][2] * cf[4][3] * pos[vi[4][2]] +
-	    cf[4][0] * cf[4][3] * pos[vi[4][3]];
+      Vec3_t pos[8] =
+        {
+	  S[p0].pos, S[p1].pos, S[p2].pos, S[p3].pos,
+	  S[p4].pos, S[p5].pos, S[p6].pos, S[p7].pos
+        };
       
-      ff3 = cf[5][0] * cf[5][1] * pos[vi[5][0]] +
-	    cf[5][2] * cf[5][1] * pos[vi[5][1]] +
-	    cf[5][2] * cf[5][3] * pos[vi[5][2]] +
-	    cf[5][0] * cf[5][3] * pos[vi[5][3]];
+      Vec3_t f1  = point(P, pos, 0);
+      Vec3_t ff1 = point(P, pos, 1);
+      Vec3_t f2  = point(P, pos, 2);
+      Vec3_t ff2 = point(P, pos, 3);
+      Vec3_t f3  = point(P, pos, 4);
+      Vec3_t ff3 = point(P, pos, 5);
       
       Vec3_t l1 = f1 - ff1;
       Vec3_t l2 = f2 - ff2;
@@ -551,35 +1255,12 @@ struct HexaSpring : public Force_Function<Particle_Traits>
 	  S[p4].vel, S[p5].vel, S[p6].vel, S[p7].vel
         };
       
-      Vec3_t vf1  = cf[0][0] * cf[0][1] * vel[vi[0][0]] +
-	            cf[0][2] * cf[0][1] * vel[vi[0][1]] +
-	            cf[0][2] * cf[0][3] * vel[vi[0][2]] +
-	            cf[0][0] * cf[0][3] * vel[vi[0][3]];
-      
-      Vec3_t vff1 = cf[1][0] * cf[1][1] * vel[vi[1][0]] +
-	            cf[1][2] * cf[1][1] * vel[vi[1][1]] +
-	            cf[1][2] * cf[1][3] * vel[vi[1][2]] +
-	            cf[1][0] * cf[1][3] * vel[vi[1][3]];
-      
-      Vec3_t vf2  = cf[2][0] * cf[2][1] * vel[vi[2][0]] +
-	            cf[2][2] * cf[2][1] * vel[vi[2][1]] +
-	            cf[2][2] * cf[2][3] * vel[vi[2][2]] +
-	            cf[2][0] * cf[2][3] * vel[vi[2][3]];
-      
-      Vec3_t vff2 = cf[3][0] * cf[3][1] * vel[vi[3][0]] +
-	            cf[3][2] * cf[3][1] * vel[vi[3][1]] +
-	            cf[3][2] * cf[3][3] * vel[vi[3][2]] +
-	            cf[3][0] * cf[3][3] * vel[vi[3][3]];
-      
-      Vec3_t vf3  = cf[4][0] * cf[4][1] * vel[vi[4][0]] +
-	            cf[4][2] * cf[4][1] * vel[vi[4][1]] +
-	            cf[4][2] * cf[4][3] * vel[vi[4][2]] +
-	            cf[4][0] * cf[4][3] * vel[vi[4][3]];
-      
-      Vec3_t vff3 = cf[5][0] * cf[5][1] * vel[vi[5][0]] +
-	            cf[5][2] * cf[5][1] * vel[vi[5][1]] +
-	            cf[5][2] * cf[5][3] * vel[vi[5][2]] +
-	            cf[5][0] * cf[5][3] * vel[vi[5][3]];
+      Vec3_t vf1  = point(P, vel, 0);
+      Vec3_t vff1 = point(P, vel, 1);
+      Vec3_t vf2  = point(P, vel, 2);
+      Vec3_t vff2 = point(P, vel, 3);
+      Vec3_t vf3  = point(P, vel, 4);
+      Vec3_t vff3 = point(P, vel, 5);
       
       Vec3_t vl1 = vf1 - vff1;
       Vec3_t vl2 = vf2 - vff2;
@@ -596,18 +1277,18 @@ struct HexaSpring : public Force_Function<Particle_Traits>
       Vec3_t nl3 = l3*L3_inv;
       
 #if DAMPED
-      Vec3_t F1 = - ( ks1*(L1 - L01) + kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) + kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) + kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) + k.kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) + k.kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) + k.kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
 #else
-      Vec3_t F1 = - ( ks1*(L1 - L01) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) ) * nl3;
 #endif
       
-      Real K12  = - ( ks4*cosang12 );
-      Real K13  = - ( ks5*cosang13 );
-      Real K23  = - ( ks6*cosang23 );
+      Real K12  = - ( k.ks4*cosang12 );
+      Real K13  = - ( k.ks5*cosang13 );
+      Real K23  = - ( k.ks6*cosang23 );
       
       Vec3_t Ff1  =   F1 + K12*nl2 + K13*nl3;
       Vec3_t Fff1 = - Ff1;
@@ -635,18 +1316,18 @@ struct HexaSpring : public Force_Function<Particle_Traits>
       Vec3_t nl2 = l2*L2_inv;
       Vec3_t nl3 = l3*L3_inv;
       
-      Vec3_t F1 = - ( ks1*(L1 - L01) + kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
-      Vec3_t F2 = - ( ks2*(L2 - L02) + kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
-      Vec3_t F3 = - ( ks3*(L3 - L03) + kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) + k.kd1*animal::geometry::dot(vl1,nl1) ) * nl1;
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) + k.kd2*animal::geometry::dot(vl2,nl2) ) * nl2;
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) + k.kd3*animal::geometry::dot(vl3,nl3) ) * nl3;
 #else
-      Vec3_t F1 = - ( ks1*(L1 - L01) ) * (l1*L1_inv);
-      Vec3_t F2 = - ( ks2*(L2 - L02) ) * (l2*L2_inv);
-      Vec3_t F3 = - ( ks3*(L3 - L03) ) * (l3*L3_inv);
+      Vec3_t F1 = - ( k.ks1*(L1 - L01) ) * (l1*L1_inv);
+      Vec3_t F2 = - ( k.ks2*(L2 - L02) ) * (l2*L2_inv);
+      Vec3_t F3 = - ( k.ks3*(L3 - L03) ) * (l3*L3_inv);
 #endif
       
-      Real K12 = ( ks4*cosang12 );
-      Real K13 = ( ks5*cosang13 );
-      Real K23 = ( ks6*cosang23 );
+      Real K12 = ( k.ks4*cosang12 );
+      Real K13 = ( k.ks5*cosang13 );
+      Real K23 = ( k.ks6*cosang23 );
       
       Vec3_t Ff1  =   F1 + K12*n112 + K13*n113;
       Vec3_t Fff1 = - Ff1;
@@ -664,38 +1345,14 @@ struct HexaSpring : public Force_Function<Particle_Traits>
           Vec3_t::null(), Vec3_t::null(), Vec3_t::null(), Vec3_t::null()
 	};
       
-      frc[vi[0][0]] += cf[0][0] * cf[0][1] * Ff1;
-      frc[vi[0][1]] += cf[0][2] * cf[0][1] * Ff1;
-      frc[vi[0][2]] += cf[0][2] * cf[0][3] * Ff1;
-      frc[vi[0][3]] += cf[0][0] * cf[0][3] * Ff1;
-      
-      frc[vi[1][0]] += cf[1][0] * cf[1][1] * Fff1;
-      frc[vi[1][1]] += cf[1][2] * cf[1][1] * Fff1;
-      frc[vi[1][2]] += cf[1][2] * cf[1][3] * Fff1;
-      frc[vi[1][3]] += cf[1][0] * cf[1][3] * Fff1;
-      
-      frc[vi[2][0]] += cf[2][0] * cf[2][1] * Ff2;
-      frc[vi[2][1]] += cf[2][2] * cf[2][1] * Ff2;
-      frc[vi[2][2]] += cf[2][2] * cf[2][3] * Ff2;
-      frc[vi[2][3]] += cf[2][0] * cf[2][3] * Ff2;
+      const Vec3_t* F[6] = { &Ff1, &Fff1, &Ff2, &Fff2, &Ff3, &Fff3 };
       
-      frc[vi[3][0]] += cf[3][0] * cf[3][1] * Fff2;
-      frc[vi[3][1]] += cf[3][2] * cf[3][1] * Fff2;
-      frc[vi[3][2]] += cf[3][2] * cf[3][3] * Fff2;
-      frc[vi[3][3]] += cf[3][0] * cf[3][3] * Fff2;
-      
-      frc[vi[4][0]] += cf[4][0] * cf[4][1] * Ff3;
-      frc[vi[4][1]] += cf[4][2] * cf[4][1] * Ff3;
-      frc[vi[4][2]] += cf[4][2] * cf[4][3] * Ff3;
-      frc[vi[4][3]] += cf[4][0] * cf[4][3] * Ff3;
-      
-      frc[vi[5][0]] += cf[5][0] * cf[5][1] * Fff3;
-      frc[vi[5][1]] += cf[5][2] * cf[5][1] * Fff3;
-      frc[vi[5][2]] += cf[5][2] * cf[5][3] * Fff3;
-      frc[vi[5][3]] += cf[5][0] * cf[5][3] * Fff3;
+      for (int i = 0; i < 6; ++i)
+	for (int j = 0; j < 4; ++j)
+	  frc[ P.v[i][j] ] += P.k[i][j] * (*F[i]);
       
 #if CONSTVOL
-      Vec3_t g_pos = 0.125*( pos[0] + pos[1] + pos[2] + pos[3] +
+      Vec3_t g_pos = Real_t(0.125)*( pos[0] + pos[1] + pos[2] + pos[3] +
 			     pos[4] + pos[5] + pos[6] + pos[7]   );
       
       Vec3_t d0 = pos[0] - g_pos;
@@ -718,7 +1375,7 @@ struct HexaSpring : public Force_Function<Particle_Traits>
       
 #if ALTERN
 #if DAMPED
-      Vec3_t g_vel = 0.125*( vel[0] + vel[1] + vel[2] + vel[3] +
+      Vec3_t g_vel = Real_t(0.125)*( vel[0] + vel[1] + vel[2] + vel[3] +
 			     vel[4] + vel[5] + vel[6] + vel[7]   );
       
       Vec3_t vd0 = vel[0] - g_vel;
@@ -739,56 +1396,56 @@ struct HexaSpring : public Force_Function<Particle_Traits>
       Vec3_t nd6 = d6/D6;
       Vec3_t nd7 = d7/D7;
       
-      Vec3_t Fd0 = - ( ks*(D0 - D00) + kd*animal::geometry::dot(vd0,nd0) ) * nd0;
-      Vec3_t Fd1 = - ( ks*(D1 - D01) + kd*animal::geometry::dot(vd1,nd1) ) * nd1;
-      Vec3_t Fd2 = - ( ks*(D2 - D02) + kd*animal::geometry::dot(vd2,nd2) ) * nd2;
-      Vec3_t Fd3 = - ( ks*(D3 - D03) + kd*animal::geometry::dot(vd3,nd3) ) * nd3;
-      Vec3_t Fd4 = - ( ks*(D4 - D04) + kd*animal::geometry::dot(vd4,nd4) ) * nd4;
-      Vec3_t Fd5 = - ( ks*(D5 - D05) + kd*animal::geometry::dot(vd5,nd5) ) * nd5;
-      Vec3_t Fd6 = - ( ks*(D6 - D06) + kd*animal::geometry::dot(vd6,nd6) ) * nd6;
-      Vec3_t Fd7 = - ( ks*(D7 - D07) + kd*animal::geometry::dot(vd7,nd7) ) * nd7;
-      
-      M[p0].f += frc[0] + Fd0;
-      M[p1].f += frc[1] + Fd1;
-      M[p2].f += frc[2] + Fd2;
-      M[p3].f += frc[3] + Fd3;
-      M[p4].f += frc[4] + Fd4;
-      M[p5].f += frc[5] + Fd5;
-      M[p6].f += frc[6] + Fd6;
-      M[p7].f += frc[7] + Fd7;
+      Vec3_t Fd0 = - ( k.ks*(D0 - D00) + k.kd*animal::geometry::dot(vd0,nd0) ) * nd0;
+      Vec3_t Fd1 = - ( k.ks*(D1 - D01) + k.kd*animal::geometry::dot(vd1,nd1) ) * nd1;
+      Vec3_t Fd2 = - ( k.ks*(D2 - D02) + k.kd*animal::geometry::dot(vd2,nd2) ) * nd2;
+      Vec3_t Fd3 = - ( k.ks*(D3 - D03) + k.kd*animal::geometry::dot(vd3,nd3) ) * nd3;
+      Vec3_t Fd4 = - ( k.ks*(D4 - D04) + k.kd*animal::geometry::dot(vd4,nd4) ) * nd4;
+      Vec3_t Fd5 = - ( k.ks*(D5 - D05) + k.kd*animal::geometry::dot(vd5,nd5) ) * nd5;
+      Vec3_t Fd6 = - ( k.ks*(D6 - D06) + k.kd*animal::geometry::dot(vd6,nd6) ) * nd6;
+      Vec3_t Fd7 = - ( k.ks*(D7 - D07) + k.kd*animal::geometry::dot(vd7,nd7) ) * nd7;
+      
+      M[p0].f += Vec3_Acc( frc[0] + Fd0 );
+      M[p1].f += Vec3_Acc( frc[1] + Fd1 );
+      M[p2].f += Vec3_Acc( frc[2] + Fd2 );
+      M[p3].f += Vec3_Acc( frc[3] + Fd3 );
+      M[p4].f += Vec3_Acc( frc[4] + Fd4 );
+      M[p5].f += Vec3_Acc( frc[5] + Fd5 );
+      M[p6].f += Vec3_Acc( frc[6] + Fd6 );
+      M[p7].f += Vec3_Acc( frc[7] + Fd7 );
 #else
-      M[p0].f += frc[0] - ( ks*(D0 - D00) ) * (d0/D0);
-      M[p1].f += frc[1] - ( ks*(D1 - D01) ) * (d1/D1);
-      M[p2].f += frc[2] - ( ks*(D2 - D02) ) * (d2/D2);
-      M[p3].f += frc[3] - ( ks*(D3 - D03) ) * (d3/D3);
-      M[p4].f += frc[4] - ( ks*(D4 - D04) ) * (d4/D4);
-      M[p5].f += frc[5] - ( ks*(D5 - D05) ) * (d5/D5);
-      M[p6].f += frc[6] - ( ks*(D6 - D06) ) * (d6/D6);
-      M[p7].f += frc[7] - ( ks*(D7 - D07) ) * (d7/D7);
+      M[p0].f += Vec3_Acc( frc[0] - ( k.ks*(D0 - D00) ) * (d0/D0) );
+      M[p1].f += Vec3_Acc( frc[1] - ( k.ks*(D1 - D01) ) * (d1/D1) );
+      M[p2].f += Vec3_Acc( frc[2] - ( k.ks*(D2 - D02) ) * (d2/D2) );
+      M[p3].f += Vec3_Acc( frc[3] - ( k.ks*(D3 - D03) ) * (d3/D3) );
+      M[p4].f += Vec3_Acc( frc[4] - ( k.ks*(D4 - D04) ) * (d4/D4) );
+      M[p5].f += Vec3_Acc( frc[5] - ( k.ks*(D5 - D05) ) * (d5/D5) );
+      M[p6].f += Vec3_Acc( frc[6] - ( k.ks*(D6 - D06) ) * (d6/D6) );
+      M[p7].f += Vec3_Acc( frc[7] - ( k.ks*(D7 - D07) ) * (d7/D7) );
 #endif // DAMPED
 #else
       Real_t D = D0 + D1 + D2 + D3 + D4 + D5 + D6 + D7;
       
-      Real_t K = - ( ks*(D - L0) );
+      Real_t K = - ( k.ks*(D - L0) );
       
-      M[p0].f += frc[0] + K * (d0/D0);
-      M[p1].f += frc[1] + K * (d1/D1);
-      M[p2].f += frc[2] + K * (d2/D2);
-      M[p3].f += frc[3] + K * (d3/D3);
-      M[p4].f += frc[4] + K * (d4/D4);
-      M[p5].f += frc[5] + K * (d5/D5);
-      M[p6].f += frc[6] + K * (d6/D6);
-      M[p7].f += frc[7] + K * (d7/D7);
+      M[p0].f += Vec3_Acc( frc[0] + K * (d0/D0) );
+      M[p1].f += Vec3_Acc( frc[1] + K * (d1/D1) );
+      M[p2].f += Vec3_Acc( frc[2] + K * (d2/D2) );
+      M[p3].f += Vec3_Acc( frc[3] + K * (d3/D3) );
+      M[p4].f += Vec3_Acc( frc[4] + K * (d4/D4) );
+      M[p5].f += Vec3_Acc( frc[5] + K * (d5/D5) );
+      M[p6].f += Vec3_Acc( frc[6] + K * (d6/D6) );
+      M[p7].f += Vec3_Acc( frc[7] + K * (d7/D7) );
 #endif // ALTERN
 #else
-      M[p0].f += frc[0];
-      M[p1].f += frc[1];
-      M[p2].f += frc[2];
-      M[p3].f += frc[3];
-      M[p4].f += frc[4];
-      M[p5].f += frc[5];
-      M[p6].f += frc[6];
-      M[p7].f += frc[7];
+      M[p0].f += Vec3_Acc( frc[0] );
+      M[p1].f += Vec3_Acc( frc[1] );
+      M[p2].f += Vec3_Acc( frc[2] );
+      M[p3].f += Vec3_Acc( frc[3] );
+      M[p4].f += Vec3_Acc( frc[4] );
+      M[p5].f += Vec3_Acc( frc[5] );
+      M[p6].f += Vec3_Acc( frc[6] );
+      M[p7].f += Vec3_Acc( frc[7] );
 #endif // CONSTVOL
     }
 };
@@ -0,0 +1,656 @@
+#ifndef SELF_COLLISION_H
+#define SELF_COLLISION_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <ostream>
+#include <animal/geometry/bvh.h>
+#include <animal/geometry/triangle_batch.h>
+#include <animal/support/task_scheduler.h>
+#include "particle.h"
+
+// Self-collision detection of a surface (the boundary faces of a
+// volume mesh): pairs of its triangles that intersect each other.
+//
+// Broad phase: a bounding volume hierarchy over the triangles (see
+// animal::geometry::Bvh), built once from the first state and only
+// refit afterwards, its boxes following the vertices (from a float
+// copy of their positions, made at each step). The refit and the
+// descent of the tree against itself are split into subtrees and node
+// pairs at some depth, shared between the workers of a scheduler (see
+// parallelize()).
+//
+// With skipFlat(), flat patches are skipped as well: the tree is not
+// searched within a subtree whose triangles are connected (through
+// shared vertices, known from the build) and whose normals all lie in
+// one open hemisphere. Normals are those of a consistent orientation,
+// set by the build for each connected part of the surface (parts that
+// cannot be oriented are never skipped). The hemispheres tried are
+// those of 26 directions (to the faces, edges and corners of a cube),
+// each node keeping those that hold for all its normals. This is the
+// normal cone test without that of the contour: it is not exact, a
+// patch folding onto itself while its normals stay in one hemisphere
+// (sheared or curled by large deformations) losing its pairs. The
+// pairs found are then some of those of the exact search, much faster
+// on smooth surfaces; off by default.
+//
+// Narrow phase: two triangles not sharing a vertex intersect when an
+// edge of one crosses the other. The 6 edge-triangle tests of each
+// candidate pair are queued by each worker and run in batches by the
+// vectorized Moller-Trumbore test of animal::geometry::Triangle_Batch
+// (that of intersect_triangle.c, on segments). Coplanar triangles are
+// not reported.
+//
+// Detection only: the pairs are counted and listed, the response is
+// left to the caller.
+class Self_Collision
+{
+public:
+
+  typedef animal::geometry::Bvh Bvh;
+  typedef Bvh::Index Index;
+  typedef std::pair<Index, Index> Triangle_Pair;
+  typedef std::vector<Particle_State> State_t;
+
+  Self_Collision() : scheduler(0), depth(0), skip_flat(false), S(0)
+    {}
+
+  // Triangles of 3 vertex indices in the state (through vertices, if
+  // not empty, as for the Boundary triangles), the tree being built
+  // from state s
+  template <class Index_Container>
+  void setTriangles(const Index_Container& triangles, const std::vector<Index>& vertices,
+		    const State_t& s);
+
+  // Refit and queries shared between the workers of s (serial without)
+  void parallelize(animal::support::Task_Scheduler& s);
+
+  // Flat patches skipped by the next detect(), missing the pairs of
+  // their folds (see above)
+  void skipFlat(bool on) { skip_flat = on; }
+
+  // Tree refit to state s, then its intersecting pairs of triangles;
+  // returns their number
+  std::size_t detect(const State_t& s);
+
+  // Pairs of the last detect(), sorted
+  const std::vector<Triangle_Pair>& pairs() const { return found; }
+
+  std::size_t ntriangles() const { return tri.size()/3; }
+
+  std::size_t nvertices() const { return vtx.size(); }
+
+  // Surface summary
+  void print(std::ostream& out) const;
+
+private:
+
+  enum { BATCH = 256,    // candidate pairs per batch of tests
+	 GRAIN = 4096 };  // vertices per chunk of the float copy
+
+  typedef unsigned int Directions; // bits 2k and 2k + 1 for the hemispheres of direction k and its opposite
+
+  // Float box of triangle i, rounded outward (see Bvh::build()), and
+  // the directions of its normal
+  struct Box
+  {
+    Self_Collision* c;
+
+    void operator()(Index i, float lo[3], float hi[3]) const;
+  };
+
+  // Subtrees of a flat patch (see Bvh::selfPairs())
+  struct Flat
+  {
+    const Directions* cone;
+    const Directions* connected;
+
+    bool operator()(Index i) const { return (cone[i] & connected[i]) != 0; }
+  };
+
+  // Candidate pairs of one worker, and the intersecting ones
+  struct Worker
+  {
+    animal::geometry::Triangle_Batch<Real> batch;
+    std::vector<Triangle_Pair> candidates;
+    std::vector<Triangle_Pair> found;
+    char pad[64]; // no false sharing of the ends
+  };
+
+  // Bvh::pairs() functor of a worker
+  struct Candidate
+  {
+    Self_Collision* c;
+    Worker* w;
+
+    void operator()(Index i, Index j);
+  };
+
+  struct Copy : public animal::support::Chunk_Task
+  {
+    Self_Collision* c;
+
+    void operator()(std::size_t k, int)
+      { c->copy(k*GRAIN, std::min( (k + 1)*GRAIN, c->nvertices() )); }
+  };
+
+  struct Refit : public animal::support::Chunk_Task
+  {
+    Self_Collision* c;
+
+    void operator()(std::size_t k, int)
+      {
+	c->tree.refit(c->box(), c->roots[k]);
+	if ( c->skip_flat ) c->fitCone(c->roots[k]);
+      }
+  };
+
+  struct Query : public animal::support::Chunk_Task
+  {
+    Self_Collision* c;
+
+    void operator()(std::size_t k, int w);
+  };
+
+  Box box() { Box b; b.c = this; return b; }
+  Flat isFlat() const { Flat f; f.cone = &cone[0]; f.connected = &connected[0]; return f; }
+
+  static Directions directions(float x, float y, float z);
+
+  // Edge of sorted vertices, and 2*triangle + 1 if the triangle runs
+  // from the first one to the second
+  typedef std::pair< std::pair<Index, Index>, Index > Edge;
+
+  // Triangles flipped to agree with their neighbours, oriented[t]
+  // false for the parts that cannot be
+  void orient(const std::vector<Edge>& edges);
+
+  // Nodes whose triangles are connected
+  void connect();
+
+  // Lowest common ancestor of nodes a and b
+  Index ancestor(Index a, Index b) const;
+
+  static Index root(std::vector<Index>& parent, Index i);
+
+  // Directions of the nodes of the subtree of node i, of those above
+  // depth from node i
+  void fitCone(Index i);
+  void coneAbove(Index i, int depth);
+
+  // Float positions of vertices [first, last)
+  void copy(std::size_t first, std::size_t last);
+
+  bool share(Index i, Index j) const;
+
+  // Tests of the candidates of w
+  void flush(Worker& w);
+
+
+  std::vector<Index> vtx; // state index of each surface vertex
+  std::vector<Index> tri; // 3 vertices per triangle
+  std::vector<float> p;   // 3 coordinates per vertex, copied by detect()
+  Bvh tree;
+
+  std::vector<Directions> oriented;  // of each triangle, all if its part could be oriented, none otherwise
+  std::vector<Directions> normal;    // of each triangle
+  std::vector<Directions> cone;      // of each node, those of all its normals, none if not oriented
+  std::vector<Directions> connected; // of each node, all if connected, none otherwise
+
+  animal::support::Task_Scheduler* scheduler;
+  int depth; // of the chunks
+  bool skip_flat;
+  std::vector<Index> roots;
+  std::vector<Bvh::Node_Pair> tasks;
+
+  const State_t* S; // during detect()
+  std::vector<Worker> workers;
+  std::vector<Triangle_Pair> found;
+};
+
+template <class Index_Container>
+inline void
+Self_Collision::setTriangles(const Index_Container& triangles, const std::vector<Index>& vertices,
+			     const State_t& s)
+{
+  tri.assign( triangles.begin(), triangles.end() );
+
+  if ( !vertices.empty() )
+    vtx = vertices;
+  else
+    {
+      // Those used by the triangles
+      vtx = tri;
+      std::sort(vtx.begin(), vtx.end());
+      vtx.erase( std::unique(vtx.begin(), vtx.end()), vtx.end() );
+
+      for (std::size_t k = 0; k < tri.size(); ++k)
+	tri[k] = std::lower_bound(vtx.begin(), vtx.end(), tri[k]) - vtx.begin();
+    }
+  p.resize( 3*nvertices() );
+
+  std::vector<Edge> edges( tri.size() );
+  for (std::size_t k = 0; k < tri.size(); ++k)
+    {
+      Index a = tri[k], b = tri[k - k % 3 + (k + 1) % 3];
+      edges[k] = Edge( std::make_pair( std::min(a, b), std::max(a, b) ), 2*(k/3) + (a < b) );
+    }
+  std::sort(edges.begin(), edges.end());
+
+  orient(edges);
+
+  normal.resize( ntriangles() );
+
+  S = &s;
+  copy(0, nvertices());
+  tree.build(ntriangles(), box());
+  S = 0;
+
+  connect();
+  cone.assign(tree.size(), 0);
+
+  workers.resize(1);
+  if ( scheduler ) parallelize(*scheduler);
+}
+
+inline void
+Self_Collision::parallelize(animal::support::Task_Scheduler& s)
+{
+  scheduler = &s;
+
+  // About 8 subtrees per worker
+  const int n = s.size();
+  depth = 0;
+  while ( (1 << depth) < 8*n && (1u << depth) < ntriangles() ) ++depth;
+
+  tree.cut(depth, roots);
+  workers.resize(n);
+}
+
+inline Self_Collision::Index
+Self_Collision::ancestor(Index a, Index b) const
+{
+  Index i = 0;
+
+  for (;;)
+    {
+      const Index r = tree.right(i);
+      if ( a < r && b < r ) i = i + 1;
+      else if ( a >= r && b >= r ) i = r;
+      else return i;
+    }
+}
+
+inline Self_Collision::Index
+Self_Collision::root(std::vector<Index>& parent, Index i)
+{
+  while ( parent[i] != i )
+    i = parent[i] = parent[ parent[i] ]; // path halving
+
+  return i;
+}
+
+inline void
+Self_Collision::orient(const std::vector<Edge>& edges)
+{
+  const Index n = ntriangles();
+
+  // Neighbours across the edges of two triangles, as (triangle,
+  // 2*neighbour + 1 if one of them must be flipped)
+  std::vector<Triangle_Pair> next;
+  for (std::size_t k = 0; k < edges.size(); )
+    {
+      std::size_t m = k + 1;
+      while ( m < edges.size() && edges[m].first == edges[k].first ) ++m;
+
+      if ( m - k == 2 ) // not at a seam of several parts
+	{
+	  Index t = edges[k].second/2, u = edges[k + 1].second/2;
+	  Index same = (edges[k].second & 1) == (edges[k + 1].second & 1);
+	  next.push_back( Triangle_Pair(t, 2*u + same) );
+	  next.push_back( Triangle_Pair(u, 2*t + same) );
+	}
+
+      k = m;
+    }
+  std::sort(next.begin(), next.end());
+
+  std::vector<Index> first(n + 1, 0);
+  for (std::size_t k = 0; k < next.size(); ++k)
+    ++first[next[k].first + 1];
+  for (Index t = 0; t < n; ++t)
+    first[t + 1] += first[t];
+
+  // Each part from one of its triangles, breadth first
+  std::vector<int> flip(n, -1);
+  std::vector<Index> part;
+  oriented.assign( n, Directions(~0) );
+
+  for (Index t0 = 0; t0 < n; ++t0)
+    {
+      if ( flip[t0] >= 0 ) continue;
+
+      flip[t0] = 0;
+      part.assign(1, t0);
+      bool ok = true;
+
+      for (std::size_t q = 0; q < part.size(); ++q)
+	{
+	  const Index t = part[q];
+
+	  for (Index k = first[t]; k < first[t + 1]; ++k)
+	    {
+	      const Index u = next[k].second/2;
+	      const int f = flip[t] ^ int(next[k].second & 1);
+
+	      if ( flip[u] < 0 )
+		{
+		  flip[u] = f;
+		  part.push_back(u);
+		}
+	      else if ( flip[u] != f )
+		ok = false; // e.g. a Moebius strip
+	    }
+	}
+
+      if ( !ok )
+	for (std::size_t q = 0; q < part.size(); ++q)
+	  oriented[ part[q] ] = 0;
+    }
+
+  for (Index t = 0; t < n; ++t)
+    if ( flip[t] == 1 ) std::swap(tri[3*t + 1], tri[3*t + 2]);
+}
+
+inline void
+Self_Collision::connect()
+{
+  connected.assign(tree.size(), 0);
+  if ( !tree.size() ) return;
+
+  std::vector<Index> leaf( ntriangles() );
+  for (Index k = 0; k < tree.size(); ++k)
+    if ( tree.leaf(k) ) leaf[ tree.item(k) ] = k;
+
+  // Leaves around each vertex, in order
+  std::vector<Triangle_Pair> around( tri.size() );
+  for (std::size_t k = 0; k < tri.size(); ++k)
+    around[k] = Triangle_Pair(tri[k], leaf[k/3]);
+  std::sort(around.begin(), around.end());
+
+  // Chained: every link joins two subtrees at their common ancestor
+  std::vector< std::pair<Index, Triangle_Pair> > links;
+  for (std::size_t k = 1; k < around.size(); ++k)
+    if ( around[k].first == around[k - 1].first )
+      {
+	Index a = around[k - 1].second, b = around[k].second;
+	links.push_back( std::make_pair( ancestor(a, b), Triangle_Pair(a, b) ) );
+      }
+  std::sort(links.begin(), links.end());
+
+  // Parts of each subtree, children first (union-find over leaves)
+  std::vector<Index> parent( tree.size() ), parts( tree.size() );
+  std::size_t l = links.size();
+
+  for (Index k = tree.size(); k-- > 0; )
+    {
+      parent[k] = k;
+
+      if ( tree.leaf(k) )
+	{
+	  parts[k] = 1;
+	  connected[k] = Directions(~0);
+	  continue;
+	}
+
+      parts[k] = parts[k + 1] + parts[ tree.right(k) ];
+
+      for ( ; l > 0 && links[l - 1].first == k; --l)
+	{
+	  Index a = root(parent, links[l - 1].second.first);
+	  Index b = root(parent, links[l - 1].second.second);
+	  if ( a != b )
+	    {
+	      parent[a] = b;
+	      --parts[k];
+	    }
+	}
+
+      if ( parts[k] == 1 ) connected[k] = Directions(~0);
+    }
+}
+
+inline Self_Collision::Directions
+Self_Collision::directions(float x, float y, float z)
+{
+  // Without branches: faces, edges, then corners of the cube
+  return Directions( x > 0.0f )             | Directions( x < 0.0f ) << 1
+    | Directions( y > 0.0f ) << 2           | Directions( y < 0.0f ) << 3
+    | Directions( z > 0.0f ) << 4           | Directions( z < 0.0f ) << 5
+    | Directions( x + y > 0.0f ) << 6       | Directions( x + y < 0.0f ) << 7
+    | Directions( x - y > 0.0f ) << 8       | Directions( x - y < 0.0f ) << 9
+    | Directions( x + z > 0.0f ) << 10      | Directions( x + z < 0.0f ) << 11
+    | Directions( x - z > 0.0f ) << 12      | Directions( x - z < 0.0f ) << 13
+    | Directions( y + z > 0.0f ) << 14      | Directions( y + z < 0.0f ) << 15
+    | Directions( y - z > 0.0f ) << 16      | Directions( y - z < 0.0f ) << 17
+    | Directions( x + y + z > 0.0f ) << 18  | Directions( x + y + z < 0.0f ) << 19
+    | Directions( x + y - z > 0.0f ) << 20  | Directions( x + y - z < 0.0f ) << 21
+    | Directions( x - y + z > 0.0f ) << 22  | Directions( x - y + z < 0.0f ) << 23
+    | Directions( -x + y + z > 0.0f ) << 24 | Directions( -x + y + z < 0.0f ) << 25;
+}
+
+inline void
+Self_Collision::fitCone(Index i)
+{
+  for (Index k = tree.end(i); k-- > i; )
+    if ( tree.leaf(k) )
+      cone[k] = normal[ tree.item(k) ] & oriented[ tree.item(k) ];
+    else
+      cone[k] = cone[k + 1] & cone[ tree.right(k) ];
+}
+
+inline void
+Self_Collision::coneAbove(Index i, int depth)
+{
+  if ( depth == 0 || tree.leaf(i) ) return;
+
+  coneAbove(i + 1, depth - 1);
+  coneAbove(tree.right(i), depth - 1);
+  cone[i] = cone[i + 1] & cone[ tree.right(i) ];
+}
+
+inline void
+Self_Collision::copy(std::size_t first, std::size_t last)
+{
+  const State_t& s = *S;
+
+  for (std::size_t v = first; v < last; ++v)
+    {
+      const Vec3& x = s[ vtx[v] ].pos;
+      p[3*v] = x[0];
+      p[3*v + 1] = x[1];
+      p[3*v + 2] = x[2];
+    }
+}
+
+inline void
+Self_Collision::Box::operator()(Index i, float lo[3], float hi[3]) const
+{
+  const Index* t = &c->tri[3*i];
+
+  const float* a = &c->p[3*t[0]];
+  const float* b = &c->p[3*t[1]];
+  const float* e = &c->p[3*t[2]];
+
+  for (int d = 0; d < 3; ++d)
+    {
+      // Rounded to float by the copy, then one step outward
+      float l = std::min( std::min(a[d], b[d]), e[d] );
+      float h = std::max( std::max(a[d], b[d]), e[d] );
+
+      lo[d] = l - ( std::fabs(l)*FLT_EPSILON + FLT_MIN );
+      hi[d] = h + ( std::fabs(h)*FLT_EPSILON + FLT_MIN );
+    }
+
+  if ( c->skip_flat )
+    {
+      // In float: only the directions are kept
+      const float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      const float v[3] = { e[0] - a[0], e[1] - a[1], e[2] - a[2] };
+      c->normal[i] = directions( u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] );
+    }
+}
+
+inline bool
+Self_Collision::share(Index i, Index j) const
+{
+  const Index* a = &tri[3*i];
+  const Index* b = &tri[3*j];
+
+  for (int k = 0; k < 3; ++k)
+    if ( a[k] == b[0] || a[k] == b[1] || a[k] == b[2] ) return true;
+
+  return false;
+}
+
+inline void
+Self_Collision::Candidate::operator()(Index i, Index j)
+{
+  if ( c->share(i, j) ) return; // neighbours touch
+
+  w->candidates.push_back( Triangle_Pair( std::min(i, j), std::max(i, j) ) );
+  if ( w->candidates.size() == BATCH ) c->flush(*w);
+}
+
+inline void
+Self_Collision::flush(Worker& w)
+{
+  const State_t& s = *S;
+
+  w.batch.clear();
+
+  for (std::size_t k = 0; k < w.candidates.size(); ++k)
+    {
+      const Index* t[2] = { &tri[3*w.candidates[k].first], &tri[3*w.candidates[k].second] };
+
+      // Edges of each triangle against the other one
+      for (int a = 0; a < 2; ++a)
+	{
+	  const Vec3& p0 = s[ vtx[t[1 - a][0]] ].pos;
+	  const Vec3& p1 = s[ vtx[t[1 - a][1]] ].pos;
+	  const Vec3& p2 = s[ vtx[t[1 - a][2]] ].pos;
+
+	  for (int e = 0; e < 3; ++e)
+	    {
+	      const Vec3& o = s[ vtx[t[a][e]] ].pos;
+	      w.batch.add(o, s[ vtx[t[a][(e + 1) % 3]] ].pos - o, p0, p1, p2);
+	    }
+	}
+    }
+
+  w.batch.intersect();
+
+  for (std::size_t k = 0; k < w.candidates.size(); ++k)
+    {
+      bool hit = false;
+      for (int e = 0; e < 6; ++e)
+	hit = hit || w.batch.hit(6*k + e);
+
+      if ( hit ) w.found.push_back(w.candidates[k]);
+    }
+
+  w.candidates.clear();
+}
+
+inline void
+Self_Collision::Query::operator()(std::size_t k, int w)
+{
+  Candidate f;
+  f.c = c;
+  f.w = &c->workers[w];
+
+  if ( c->skip_flat )
+    c->tree.pairs(c->tasks[k], f, c->isFlat());
+  else
+    c->tree.pairs(c->tasks[k], f);
+  c->flush(*f.w);
+}
+
+inline std::size_t
+Self_Collision::detect(const State_t& s)
+{
+  found.clear();
+  if ( tri.empty() ) return 0;
+
+  S = &s;
+
+  for (std::size_t w = 0; w < workers.size(); ++w)
+    workers[w].found.clear();
+
+  if ( scheduler && scheduler->size() > 1 )
+    {
+      Copy copy;
+      copy.c = this;
+      scheduler->run(copy, (nvertices() + GRAIN - 1)/GRAIN);
+
+      Refit refit;
+      refit.c = this;
+      scheduler->run(refit, roots.size());
+      tree.refitAbove(depth);
+
+      if ( skip_flat )
+	{
+	  coneAbove(0, depth);
+	  tree.tasks(depth, tasks, isFlat());
+	}
+      else
+	tree.tasks(depth, tasks);
+
+      Query query;
+      query.c = this;
+      scheduler->run(query, tasks.size());
+    }
+  else
+    {
+      copy(0, nvertices());
+      tree.refit( box() );
+
+      Candidate f;
+      f.c = this;
+      f.w = &workers[0];
+
+      if ( skip_flat )
+	{
+	  fitCone(0);
+	  tree.selfPairs(0, f, isFlat());
+	}
+      else
+	tree.selfPairs(0, f);
+      flush(workers[0]);
+    }
+
+  for (std::size_t w = 0; w < workers.size(); ++w)
+    found.insert(found.end(), workers[w].found.begin(), workers[w].found.end());
+  std::sort(found.begin(), found.end()); // same order for any number of workers
+
+  S = 0;
+
+  return found.size();
+}
+
+inline void
+Self_Collision::print(std::ostream& out) const
+{
+  out << "Self-collisions of " << ntriangles() << " surface triangles, "
+      << tree.size() << " tree nodes";
+  if ( scheduler && scheduler->size() > 1 )
+    out << ", " << roots.size() << " refit chunks";
+  if ( skip_flat )
+    out << ", flat patches skipped";
+  out << std::endl;
+}
+
+#endif // SELF_COLLISION_H
@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <GL/gl.h>
+#include <animal/support/triple_buffer.h>
+#include "particle.h"
+
+// What the display needs of the simulation, copied by the
+// simulation thread and handed to the display through a
+// triple buffer (see Snapshot_Buffer). Coordinates are stored
+// as floats, ready to be uploaded in vertex buffers.
+
+struct Snapshot
+{
+  Real date;                  // simulation date (in s)
+  std::vector<GLfloat> pos;    // particle positions (x, y, z)
+  std::vector<GLfloat> fibers; // displayed fiber end points (x, y, z), by pairs
+
+  Snapshot() : date(0.0)
+    {}
+
+  void copyPositions(const std::vector<Particle_State>& S)
+    {
+      pos.resize( 3*S.size() );
+
+      for (std::vector<Particle_State>::size_type i = 0; i < S.size(); ++i)
+	set(pos, i, S[i].pos);
+    }
+
+  // Positions of the particles listed in vertices only, in this order
+  void copyPositions(const std::vector<Particle_State>& S, const std::vector<GLuint>& vertices)
+    {
+      pos.resize( 3*vertices.size() );
+
+      for (std::vector<GLuint>::size_type i = 0; i < vertices.size(); ++i)
+	set(pos, i, S[ vertices[i] ].pos);
+    }
+
+  void resizeFibers(std::vector<GLfloat>::size_type n)
+    {
+      fibers.resize(6*n);
+    }
+  void setFiber(std::vector<GLfloat>::size_type i, const Vec3& f, const Vec3& ff)
+    {
+      set(fibers, 2*i, f);
+      set(fibers, 2*i + 1, ff);
+    }
+
+  static void set(std::vector<GLfloat>& v, std::vector<GLfloat>::size_type i, const Vec3& p)
+    {
+      v[3*i]     = static_cast<GLfloat>( p[0] );
+      v[3*i + 1] = static_cast<GLfloat>( p[1] );
+      v[3*i + 2] = static_cast<GLfloat>( p[2] );
+    }
+};
+
+typedef animal::support::Triple_Buffer<Snapshot> Snapshot_Buffer;
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,83 @@
+#!/bin/sh
+#
+# regress.sh
+# Reruns the VOLINFO scenarios of the tables in this directory
+# without display, and checks the volume relative variation
+# (DV/V0 in %) against the stored curves.
+#
+# Usage: regress.sh [tolerance in % (1e-3)]
+# CXX and CXXFLAGS are taken from the environment.
+# Exits with status 1 if any curve is off by more than tolerance.
+#
+
+TOL=${1:-1e-3}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2"}
+LIBS="-lglut -lGLU -lEGL -lGL -lpthread"
+
+VOL=`cd \`dirname $0\` && pwd`
+TOP=$VOL/..
+TMP=${TMPDIR:-/tmp}/regress.$$
+mkdir -p $TMP || exit 1
+
+CUBE="-DCUBE_PARAMS=1 -DBEAM_PARAMS=0"
+FAILED=0
+
+# build name program flags
+build()
+{
+    SRC=$TOP/$2.C
+    [ $2 = move_tetra ] && SRC="$SRC $TOP/intersect_triangle.c"
+    $CXX $CXXFLAGS -w -DVOLINFO $3 -I$TOP -o $TMP/$1 $SRC $LIBS || exit 1
+}
+
+# run name mesh duration: leaves $TMP/$1.dat and prints wall time
+run()
+{
+    mkdir -p $TMP/$1.d
+    ( cd $TMP/$1.d && $TMP/$1 -batch $3 $TOP/examples/tetra/$2/cube.mesh ) > $TMP/$1.log || exit 1
+    mv $TMP/$1.d/vol.dat $TMP/$1.dat
+    WALL=`sed -n 's/.*(\(.*\) s per simulated second).*/\1/p' $TMP/$1.log`
+}
+
+# compare name table column: DV/V0 of run name against column of table
+compare()
+{
+    awk -v COL=$3 -v TOL=$TOL -v NAME="$1 / `basename $2`" -v WALL=$WALL '
+        NR == FNR { if ( FNR > 1 ) ref[$1] = $COL; next }
+        FNR > 1 && ($1 in ref) {
+            d = $3 - ref[$1]; if ( d < 0 ) d = -d
+            if ( d > max ) { max = d; at = $1 }
+            ++n
+        }
+        END {
+            ok = ( n > 0 && max <= TOL )
+            printf "%-4s %-24s %5d points  max |diff| %-11g at t = %-6s %g s per simulated second\n",
+                   ok ? "ok" : "FAIL", NAME, n, max, at, WALL
+            exit !ok
+        }' $2 $TMP/$1.dat || FAILED=1
+}
+
+# Mass-spring (MS), fibers (MT0) and fibers with volume constraint (MT)
+build ms   move_tetra_ms "-DDAMPED $CUBE"
+build mt_0 move_tetra    "-DALTERN -DDAMPED $CUBE"
+build mt   move_tetra    "-DALTERN -DDAMPED -DCONSTVOL $CUBE"
+build beam move_tetra    "-DALTERN -DDAMPED"
+
+LAST() { tail -n 1 $1 | cut -f 1; }
+
+run ms   cube_343 `LAST $VOL/vol_ms.txt`
+compare ms   $VOL/vol_ms.txt      3
+compare ms   $VOL/vol_results.txt 2
+run mt_0 cube_343 `LAST $VOL/vol_mt_0.txt`
+compare mt_0 $VOL/vol_mt_0.txt    3
+compare mt_0 $VOL/vol_results.txt 3
+run mt   cube_343 `LAST $VOL/vol_mt.txt`
+compare mt   $VOL/vol_mt.txt      3
+compare mt   $VOL/vol_results.txt 4
+run beam beam_336 `LAST $VOL/vol.txt`
+compare beam $VOL/vol.txt         3
+
+rm -rf $TMP
+
+exit $FAILED